@@ -0,0 +1,61 @@
+// Contention benchmark for pubsub::Channel: the unbounded deque channel
+// against the bounded ring-buffer channel, with several producers and
+// consumers hammering one channel.
+//
+//   channel_bench [events] [producers] [consumers] [capacity]
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "pubsub/broker.hpp"
+
+using Channel = pubsub::Channel<std::uint64_t>;
+
+// Returns events per second.
+static double run(Channel& ch, std::size_t events, std::size_t producers, std::size_t consumers) {
+  std::atomic<std::size_t> received{0};
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+
+  for (std::size_t c = 0; c < consumers; c++) {
+    threads.emplace_back([&] {
+      while (ch.pop()) received.fetch_add(1, std::memory_order_relaxed);
+    });
+  }
+  std::vector<std::thread> writers;
+  for (std::size_t p = 0; p < producers; p++) {
+    writers.emplace_back([&, p] {
+      for (std::size_t i = p; i < events; i += producers) ch.push(i);
+    });
+  }
+  for (auto& t : writers) t.join();
+  // pop() keeps returning queued values after close() until the queue is empty.
+  while (received.load() < events) std::this_thread::yield();
+  ch.close();
+  for (auto& t : threads) t.join();
+
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return (double)events / elapsed.count();
+}
+
+int main(int argc, char** argv) {
+  std::size_t events = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 800000;
+  std::size_t producers = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 4;
+  std::size_t consumers = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 3;
+  std::size_t capacity = argc > 4 ? std::strtoull(argv[4], nullptr, 10) : 1024;
+
+  std::printf("%zu events, %zu producers, %zu consumers\n", events, producers, consumers);
+  for (int round = 0; round < 3; round++) {
+    Channel deque;
+    Channel ring(capacity);
+    double d = run(deque, events, producers, consumers);
+    double r = run(ring, events, producers, consumers);
+    std::printf("round %d: deque %10.0f ev/s   ring(%zu) %10.0f ev/s   x%.2f\n", round, d,
+                capacity, r, r / d);
+  }
+  return 0;
+}
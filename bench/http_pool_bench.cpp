@@ -0,0 +1,181 @@
+// Multi-step LLM turns against a local mock server: a fresh httplib::Client
+// per request (as call_llm_api did before llm::HttpPool) against leasing
+// keep-alive clients from the pool.
+//
+// The mock server can hold back the first response on every new connection
+// by --handshake-ms, standing in for the TLS handshake and round trips to a
+// remote endpoint that a loopback TCP connect doesn't cost.
+//
+//   http_pool_bench [turns] [steps] [threads] [handshake-ms]
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "httplib.h"
+#include "llm/http_pool.hpp"
+
+// Answers every request on a connection with a small completion, keeping the
+// connection open, and counts the connections it accepted.
+class MockServer {
+ public:
+  explicit MockServer(std::chrono::milliseconds handshake) : handshake_(handshake) {
+    fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(fd_, (sockaddr*)&addr, sizeof(addr));
+    socklen_t len = sizeof(addr);
+    getsockname(fd_, (sockaddr*)&addr, &len);
+    port_ = ntohs(addr.sin_port);
+    listen(fd_, 128);
+    accept_thread_ = std::thread([this] {
+      while (true) {
+        int conn = accept(fd_, nullptr, nullptr);
+        if (conn < 0) return;
+        accepted_++;
+        std::lock_guard<std::mutex> lk(mu_);
+        conns_.push_back(conn);
+        workers_.emplace_back([this, conn] { serve(conn); });
+      }
+    });
+  }
+
+  ~MockServer() {
+    shutdown(fd_, SHUT_RDWR);
+    close(fd_);
+    accept_thread_.join();
+    std::lock_guard<std::mutex> lk(mu_);
+    for (int conn : conns_) shutdown(conn, SHUT_RDWR);
+    for (auto& t : workers_) t.join();
+    for (int conn : conns_) close(conn);
+  }
+
+  int port() const { return port_; }
+  std::size_t accepted() const { return accepted_; }
+
+ private:
+  void serve(int conn) {
+    static const std::string body =
+        R"({"choices":[{"message":{"role":"assistant","content":"ok"}}]})";
+    static const std::string response =
+        "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nConnection: keep-alive\r\n"
+        "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+
+    bool first = true;
+    std::string buf;
+    char chunk[4096];
+    while (true) {
+      // Headers, then Content-Length bytes of body.
+      std::size_t end;
+      while ((end = buf.find("\r\n\r\n")) == std::string::npos) {
+        auto n = read(conn, chunk, sizeof(chunk));
+        if (n <= 0) return;
+        buf.append(chunk, (std::size_t)n);
+      }
+      std::size_t length = 0;
+      auto cl = buf.find("Content-Length:");
+      if (cl == std::string::npos) cl = buf.find("content-length:");
+      if (cl != std::string::npos && cl < end) length = std::strtoull(buf.c_str() + cl + 15, nullptr, 10);
+      while (buf.size() < end + 4 + length) {
+        auto n = read(conn, chunk, sizeof(chunk));
+        if (n <= 0) return;
+        buf.append(chunk, (std::size_t)n);
+      }
+      buf.erase(0, end + 4 + length);
+
+      if (first && handshake_.count() > 0) std::this_thread::sleep_for(handshake_);
+      first = false;
+      if (write(conn, response.data(), response.size()) != (ssize_t)response.size()) return;
+    }
+  }
+
+  std::chrono::milliseconds handshake_;
+  int fd_ = -1;
+  int port_ = 0;
+  std::atomic<std::size_t> accepted_{0};
+  std::thread accept_thread_;
+  std::mutex mu_;
+  std::vector<int> conns_;
+  std::vector<std::thread> workers_;
+};
+
+struct Result {
+  double ms = 0;
+  std::size_t connections = 0;
+  std::size_t failures = 0;
+};
+
+// `turns` turns of `steps` sequential requests each, spread over `threads`.
+template <typename Call>
+static Result run(std::chrono::milliseconds handshake, std::size_t turns, std::size_t steps,
+                  std::size_t threads, Call call) {
+  MockServer server(handshake);
+  std::string origin = "http://127.0.0.1:" + std::to_string(server.port());
+  std::string body(2048, 'x');
+  std::atomic<std::size_t> next{0};
+  std::atomic<std::size_t> failures{0};
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+  for (std::size_t t = 0; t < threads; t++) {
+    workers.emplace_back([&] {
+      while (next.fetch_add(1) < turns) {
+        for (std::size_t s = 0; s < steps; s++) {
+          if (!call(origin, body)) failures++;
+        }
+      }
+    });
+  }
+  for (auto& w : workers) w.join();
+  std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+  return Result{elapsed.count(), server.accepted(), failures.load()};
+}
+
+static bool post(httplib::Client& cli, const std::string& body) {
+  auto res = cli.Post("/v1/chat/completions", httplib::Headers{}, body, "application/json");
+  return res && res->status == 200;
+}
+
+int main(int argc, char** argv) {
+  std::size_t turns = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200;
+  std::size_t steps = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 3;
+  std::size_t threads = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 4;
+  std::chrono::milliseconds handshake(argc > 4 ? std::strtoull(argv[4], nullptr, 10) : 0);
+
+  auto fresh = [](const std::string& origin, const std::string& body) {
+    httplib::Client cli(origin);
+    cli.set_keep_alive(true);
+    return post(cli, body);
+  };
+  llm::HttpPool pool(llm::HttpPool::Options{threads});
+  auto pooled = [&pool](const std::string& origin, const std::string& body) {
+    auto cli = pool.acquire(origin);
+    bool ok = post(*cli, body);
+    if (!ok) cli.discard();
+    return ok;
+  };
+
+  std::printf("%zu turns x %zu steps on %zu threads, %lld ms per new connection\n", turns, steps,
+              threads, (long long)handshake.count());
+  auto a = run(handshake, turns, steps, threads, fresh);
+  auto b = run(handshake, turns, steps, threads, pooled);
+  double calls = (double)(turns * steps);
+  std::printf("fresh client  %9.1f ms  %7.3f ms/call  %5zu connections  %zu failed\n", a.ms,
+              a.ms / calls, a.connections, a.failures);
+  std::printf("HttpPool      %9.1f ms  %7.3f ms/call  %5zu connections  %zu failed\n", b.ms,
+              b.ms / calls, b.connections, b.failures);
+  return a.failures + b.failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,52 @@
+// Cost of pubsub::Broker::publish as the number of subscribers grows. Each
+// subscriber is a bounded DropOldest channel nobody drains, so the numbers are
+// the broker's fan-out plus one push per subscriber.
+//
+//   publish_bench [events]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "pubsub/broker.hpp"
+
+struct Payload {
+  std::string text;
+};
+
+// Returns nanoseconds per publish.
+template <typename Subscribe>
+static double run(std::size_t subscribers, std::size_t events, Subscribe subscribe) {
+  pubsub::Broker<Payload> broker;
+  pubsub::SubscribeOptions opts{.capacity = 256, .overflow = pubsub::Overflow::DropOldest};
+  std::vector<decltype(subscribe(broker, opts))> subs;
+  for (std::size_t i = 0; i < subscribers; i++) subs.push_back(subscribe(broker, opts));
+
+  Payload payload{std::string(64, 'x')};
+  auto start = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < events; i++) {
+    broker.publish(pubsub::EventType::Created, payload);
+  }
+  std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / (double)events;
+}
+
+int main(int argc, char** argv) {
+  std::size_t events = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+
+  auto by_value = [](pubsub::Broker<Payload>& b, pubsub::SubscribeOptions o) {
+    return b.subscribe(o);
+  };
+  auto shared = [](pubsub::Broker<Payload>& b, pubsub::SubscribeOptions o) {
+    return b.subscribe_shared(o);
+  };
+
+  std::printf("%zu events per row\n", events);
+  std::printf("%12s %14s %14s\n", "subscribers", "subscribe ns", "shared ns");
+  for (std::size_t n : {0, 1, 4, 16, 64}) {
+    std::printf("%12zu %14.1f %14.1f\n", n, run(n, events, by_value), run(n, events, shared));
+  }
+  return 0;
+}
@@ -0,0 +1,127 @@
+// Insert and page-read loops over the real schema, compiling each statement
+// per call (sqlite3_prepare_v2/sqlite3_finalize, as before db::Db cached them)
+// against checking it out of Db's statement cache.
+//
+// Runs with synchronous = OFF so the WAL fsync, which otherwise dominates an
+// insert, doesn't hide the compile cost.
+//
+//   statement_cache_bench [rows]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+
+#include <sqlite3.h>
+
+#include "db/db.hpp"
+#include "db/id.hpp"
+
+static const char* k_insert =
+    "INSERT INTO messages(id, session_id, role, content, created_at, blob_hash) "
+    "VALUES(?, ?, ?, ?, ?, ?);";
+static const char* k_page =
+    "SELECT id, session_id, role, content, created_at, blob_hash FROM messages "
+    "WHERE session_id = ?1 AND id > ?2 ORDER BY id ASC LIMIT ?3;";
+
+// Compiles sql afresh per use, finalizing on destruction.
+class Uncached {
+ public:
+  Uncached(db::Db& db, const char* sql) {
+    if (sqlite3_prepare_v2(db.get(), sql, -1, &stmt_, nullptr) != SQLITE_OK) {
+      throw std::runtime_error(sqlite3_errmsg(db.get()));
+    }
+  }
+  Uncached(const Uncached&) = delete;
+  Uncached& operator=(const Uncached&) = delete;
+  ~Uncached() { sqlite3_finalize(stmt_); }
+  operator sqlite3_stmt*() const { return stmt_; }
+
+ private:
+  sqlite3_stmt* stmt_ = nullptr;
+};
+
+static void step_done(db::Db& db, sqlite3_stmt* stmt) {
+  if (sqlite3_step(stmt) != SQLITE_DONE) throw std::runtime_error(sqlite3_errmsg(db.get()));
+}
+
+static void bind_insert(sqlite3_stmt* stmt, const std::string& id, const std::string& session) {
+  sqlite3_bind_text(stmt, 1, id.c_str(), -1, SQLITE_TRANSIENT);
+  sqlite3_bind_text(stmt, 2, session.c_str(), -1, SQLITE_TRANSIENT);
+  sqlite3_bind_text(stmt, 3, "user", -1, SQLITE_STATIC);
+  sqlite3_bind_text(stmt, 4, "a short message body", -1, SQLITE_STATIC);
+  sqlite3_bind_int64(stmt, 5, 1700000000);
+  sqlite3_bind_null(stmt, 6);
+}
+
+// Reads the session 20 rows at a time; returns rows seen.
+template <typename Prepare>
+static std::size_t read_pages(db::Db& db, const std::string& session, Prepare prepare) {
+  std::size_t rows = 0;
+  std::string cursor;
+  while (true) {
+    auto stmt = prepare(db, k_page);
+    sqlite3_bind_text(stmt, 1, session.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 2, cursor.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int64(stmt, 3, 20);
+    std::size_t n = 0;
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+      cursor = (const char*)sqlite3_column_text(stmt, 0);
+      n++;
+    }
+    if (rc != SQLITE_DONE) throw std::runtime_error(sqlite3_errmsg(db.get()));
+    rows += n;
+    if (n < 20) return rows;
+  }
+}
+
+template <typename Prepare>
+static void run(const char* name, std::size_t rows, Prepare prepare) {
+  namespace fs = std::filesystem;
+  auto dir = fs::temp_directory_path() / "openvim_statement_cache_bench";
+  fs::remove_all(dir);
+  db::Tuning tuning;
+  tuning.synchronous = "OFF";
+  auto db = db::connect(dir.string(), tuning);
+
+  std::string session = db::new_id();
+  {
+    auto stmt = prepare(db, "INSERT INTO sessions(id, title, created_at) VALUES(?, 'bench', 0);");
+    sqlite3_bind_text(stmt, 1, session.c_str(), -1, SQLITE_TRANSIENT);
+    step_done(db, stmt);
+  }
+
+  // One row per transaction, like message::Service::create without
+  // write-behind.
+  auto start = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < rows; i++) {
+    db.exec("BEGIN;");
+    auto stmt = prepare(db, k_insert);
+    bind_insert(stmt, db::new_id(), session);
+    step_done(db, stmt);
+    db.exec("COMMIT;");
+  }
+  std::chrono::duration<double, std::micro> insert = std::chrono::steady_clock::now() - start;
+
+  start = std::chrono::steady_clock::now();
+  std::size_t read = read_pages(db, session, prepare);
+  std::chrono::duration<double, std::micro> list = std::chrono::steady_clock::now() - start;
+
+  std::printf("%-10s insert %7.2f us/row   list %7.2f us/page (%zu rows)\n", name,
+              insert.count() / (double)rows, list.count() / (double)((read + 19) / 20), read);
+  fs::remove_all(dir);
+}
+
+int main(int argc, char** argv) {
+  std::size_t rows = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20000;
+  auto uncached = [](db::Db& db, const char* sql) { return Uncached(db, sql); };
+  auto cached = [](db::Db& db, const char* sql) { return db.prepare(sql); };
+  for (int round = 0; round < 2; round++) {
+    run("uncached", rows, uncached);
+    run("cached", rows, cached);
+  }
+  return 0;
+}
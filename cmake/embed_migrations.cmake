@@ -0,0 +1,55 @@
+# Generates a header embedding migrations/*.up.sql as a constexpr table.
+# Usage: cmake -DMIGRATIONS_DIR=<dir> -DOUTPUT=<header> -P embed_migrations.cmake
+
+file(GLOB ups "${MIGRATIONS_DIR}/*.up.sql")
+list(SORT ups)
+
+set(entries "")
+set(last 0)
+foreach(path IN LISTS ups)
+  get_filename_component(name "${path}" NAME)
+  string(REPLACE ".up.sql" "" version "${name}")
+  if(NOT version MATCHES "^([0-9]+)_")
+    message(FATAL_ERROR "migration ${name} must start with a number")
+  endif()
+  math(EXPR number "${CMAKE_MATCH_1}")
+  math(EXPR expected "${last} + 1")
+  if(NOT number EQUAL expected)
+    message(FATAL_ERROR "migration ${name} breaks the numbering (expected ${expected})")
+  endif()
+  set(last ${number})
+
+  file(READ "${path}" sql)
+  if(sql MATCHES "\\)openvim_sql\"")
+    message(FATAL_ERROR "migration ${name} contains the raw string delimiter")
+  endif()
+  string(APPEND entries "    {${number}, \"${version}\", R\"openvim_sql(${sql})openvim_sql\"},\n")
+endforeach()
+
+set(content "// Generated by cmake/embed_migrations.cmake from migrations/*.up.sql. Do not edit.
+#pragma once
+
+#include <string_view>
+
+namespace db::embedded {
+
+struct Migration {
+  int number;  // numeric prefix; also the PRAGMA user_version once applied
+  std::string_view version;
+  std::string_view up_sql;
+};
+
+inline constexpr Migration k_migrations[] = {
+${entries}};
+
+}  // namespace db::embedded
+")
+
+# Only touch the file when it changes so dependents don't rebuild needlessly.
+if(EXISTS "${OUTPUT}")
+  file(READ "${OUTPUT}" old)
+  if(old STREQUAL content)
+    return()
+  endif()
+endif()
+file(WRITE "${OUTPUT}" "${content}")
@@ -0,0 +1,8 @@
+-- openvim full-text search rollback
+
+DROP TRIGGER IF EXISTS messages_fts_au;
+DROP TRIGGER IF EXISTS messages_fts_ad;
+DROP TRIGGER IF EXISTS messages_fts_ai;
+DROP TABLE IF EXISTS messages_fts;
+DROP INDEX IF EXISTS idx_messages_seq;
+ALTER TABLE messages DROP COLUMN seq;
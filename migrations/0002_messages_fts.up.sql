@@ -0,0 +1,38 @@
+-- openvim full-text search over message content
+
+-- messages is keyed by TEXT id, so its rowid is implicit and VACUUM may
+-- renumber it. The index is keyed on seq instead: an explicit INTEGER that
+-- the insert trigger assigns and that nothing else rewrites.
+ALTER TABLE messages ADD COLUMN seq INTEGER;
+UPDATE messages SET seq = rowid;
+CREATE UNIQUE INDEX IF NOT EXISTS idx_messages_seq ON messages(seq);
+
+-- External-content FTS5 index: the text lives only in messages, the index
+-- stores tokens keyed by messages.seq and is kept in sync by triggers.
+CREATE VIRTUAL TABLE IF NOT EXISTS messages_fts USING fts5(
+  content,
+  content = 'messages',
+  content_rowid = 'seq',
+  tokenize = 'unicode61 remove_diacritics 2'
+);
+
+-- Inserts don't name seq; the newest row takes the next one. Reusing the seq
+-- of a deleted newest row is harmless, its index entry went with it.
+CREATE TRIGGER IF NOT EXISTS messages_fts_ai AFTER INSERT ON messages BEGIN
+  UPDATE messages SET seq = (SELECT coalesce(max(seq), 0) + 1 FROM messages)
+  WHERE rowid = new.rowid AND new.seq IS NULL;
+  INSERT INTO messages_fts(rowid, content)
+  SELECT seq, content FROM messages WHERE rowid = new.rowid;
+END;
+
+CREATE TRIGGER IF NOT EXISTS messages_fts_ad AFTER DELETE ON messages BEGIN
+  INSERT INTO messages_fts(messages_fts, rowid, content) VALUES ('delete', old.seq, old.content);
+END;
+
+CREATE TRIGGER IF NOT EXISTS messages_fts_au AFTER UPDATE OF content ON messages BEGIN
+  INSERT INTO messages_fts(messages_fts, rowid, content) VALUES ('delete', old.seq, old.content);
+  INSERT INTO messages_fts(rowid, content) VALUES (new.seq, new.content);
+END;
+
+-- Index rows that existed before this migration.
+INSERT INTO messages_fts(messages_fts) VALUES ('rebuild');
@@ -0,0 +1,9 @@
+-- openvim blob store rollback
+-- Messages that pointed at blobs keep only their preview in content.
+-- messages.blob_hash stays: SQLite cannot drop a column carrying a foreign key.
+
+UPDATE messages SET blob_hash = NULL WHERE blob_hash IS NOT NULL;
+DROP TRIGGER IF EXISTS messages_blob_ad;
+DROP TRIGGER IF EXISTS messages_blob_ai;
+DROP TABLE IF EXISTS blob_data;
+DROP TABLE IF EXISTS blobs;
@@ -0,0 +1,31 @@
+-- openvim content-addressed blob store for large message payloads
+
+-- One row per distinct payload, keyed by the SHA-256 of the uncompressed
+-- bytes. refcount counts messages pointing at it (maintained by triggers).
+CREATE TABLE IF NOT EXISTS blobs (
+  hash TEXT PRIMARY KEY,
+  size INTEGER NOT NULL,
+  encoding TEXT NOT NULL,
+  refcount INTEGER NOT NULL DEFAULT 0
+);
+
+-- Payload bytes live apart from the refcount so the rows opened for
+-- incremental reads are never updated underneath a reader.
+CREATE TABLE IF NOT EXISTS blob_data (
+  hash TEXT PRIMARY KEY REFERENCES blobs(hash) ON DELETE CASCADE,
+  data BLOB NOT NULL
+);
+
+-- When set, messages.content holds only a preview of the blob.
+ALTER TABLE messages ADD COLUMN blob_hash TEXT REFERENCES blobs(hash);
+
+CREATE TRIGGER IF NOT EXISTS messages_blob_ai AFTER INSERT ON messages
+WHEN new.blob_hash IS NOT NULL BEGIN
+  UPDATE blobs SET refcount = refcount + 1 WHERE hash = new.blob_hash;
+END;
+
+CREATE TRIGGER IF NOT EXISTS messages_blob_ad AFTER DELETE ON messages
+WHEN old.blob_hash IS NOT NULL BEGIN
+  UPDATE blobs SET refcount = refcount - 1 WHERE hash = old.blob_hash;
+  DELETE FROM blobs WHERE hash = old.blob_hash AND refcount <= 0;
+END;
@@ -0,0 +1,5 @@
+-- The original random ids are gone; rewritten ids stay valid TEXT keys, so
+-- only the index change is reverted.
+
+DROP INDEX IF EXISTS idx_messages_session_id;
+CREATE INDEX IF NOT EXISTS idx_messages_session_created ON messages(session_id, created_at);
@@ -0,0 +1,42 @@
+-- openvim time-ordered ids
+--
+-- Rewrites existing random ids into the db::new_id() layout so old and new
+-- rows share one ordering: 12 hex digits of milliseconds, a 4-digit sequence
+-- and the last 16 hex digits of the old id. Rows created in the same second
+-- are spread over its milliseconds in (created_at, rowid) order, which is the
+-- order they were listed in before. Past the 1000th row of a second the
+-- millisecond stays at .999 and the sequence counts on, so no row spills into
+-- the next second.
+
+PRAGMA defer_foreign_keys = ON;
+
+CREATE TEMP TABLE session_ids (old_id TEXT PRIMARY KEY, new_id TEXT NOT NULL);
+INSERT INTO session_ids(old_id, new_id)
+SELECT id,
+       printf('%012x%04x', created_at * 1000 + min(n, 999), min(max(n - 999, 0), 65535))
+         || substr(id, 17)
+FROM (SELECT id, created_at,
+             row_number() OVER (PARTITION BY created_at ORDER BY rowid) - 1 AS n
+      FROM sessions);
+
+CREATE TEMP TABLE message_ids (old_id TEXT PRIMARY KEY, new_id TEXT NOT NULL);
+INSERT INTO message_ids(old_id, new_id)
+SELECT id,
+       printf('%012x%04x', created_at * 1000 + min(n, 999), min(max(n - 999, 0), 65535))
+         || substr(id, 17)
+FROM (SELECT id, created_at,
+             row_number() OVER (PARTITION BY created_at ORDER BY rowid) - 1 AS n
+      FROM messages);
+
+UPDATE messages SET
+  id = (SELECT new_id FROM message_ids WHERE old_id = messages.id),
+  session_id = coalesce((SELECT new_id FROM session_ids WHERE old_id = messages.session_id),
+                        session_id);
+UPDATE sessions SET id = (SELECT new_id FROM session_ids WHERE old_id = sessions.id);
+
+DROP TABLE message_ids;
+DROP TABLE session_ids;
+
+-- Listing and paging now walk (session_id, id).
+DROP INDEX IF EXISTS idx_messages_session_created;
+CREATE INDEX IF NOT EXISTS idx_messages_session_id ON messages(session_id, id);
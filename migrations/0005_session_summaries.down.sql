@@ -0,0 +1,9 @@
+-- openvim session summaries rollback
+
+DROP TRIGGER IF EXISTS sessions_summary_au;
+DROP TRIGGER IF EXISTS sessions_summary_ad;
+DROP TRIGGER IF EXISTS sessions_summary_ai;
+DROP INDEX IF EXISTS idx_sessions_last_activity;
+ALTER TABLE sessions DROP COLUMN preview;
+ALTER TABLE sessions DROP COLUMN last_message_at;
+ALTER TABLE sessions DROP COLUMN message_count;
@@ -0,0 +1,50 @@
+-- openvim denormalized session summaries
+--
+-- Each session carries its message count, the created_at of its newest
+-- message and a preview of that message's content, kept current by triggers
+-- so a session list is one indexed read with no per-session queries.
+
+ALTER TABLE sessions ADD COLUMN message_count INTEGER NOT NULL DEFAULT 0;
+ALTER TABLE sessions ADD COLUMN last_message_at INTEGER;
+ALTER TABLE sessions ADD COLUMN preview TEXT NOT NULL DEFAULT '';
+
+-- Sessions without messages count as active from their creation.
+CREATE INDEX IF NOT EXISTS idx_sessions_last_activity
+  ON sessions(coalesce(last_message_at, created_at), id);
+
+-- Import, restore and write-behind batches can insert rows older than the
+-- session's newest, so the newest-message columns only move when the new row
+-- is the highest id (one seek on idx_messages_session_id).
+CREATE TRIGGER IF NOT EXISTS sessions_summary_ai AFTER INSERT ON messages BEGIN
+  UPDATE sessions SET
+    message_count = message_count + 1,
+    last_message_at = CASE
+      WHEN new.id = (SELECT max(id) FROM messages WHERE session_id = new.session_id)
+      THEN new.created_at ELSE last_message_at END,
+    preview = CASE
+      WHEN new.id = (SELECT max(id) FROM messages WHERE session_id = new.session_id)
+      THEN substr(new.content, 1, 200) ELSE preview END
+  WHERE id = new.session_id;
+END;
+
+CREATE TRIGGER IF NOT EXISTS sessions_summary_ad AFTER DELETE ON messages BEGIN
+  UPDATE sessions SET
+    message_count = message_count - 1,
+    last_message_at = (SELECT created_at FROM messages WHERE session_id = old.session_id
+                       ORDER BY id DESC LIMIT 1),
+    preview = coalesce((SELECT substr(content, 1, 200) FROM messages
+                        WHERE session_id = old.session_id ORDER BY id DESC LIMIT 1), '')
+  WHERE id = old.session_id;
+END;
+
+CREATE TRIGGER IF NOT EXISTS sessions_summary_au AFTER UPDATE OF content ON messages
+WHEN new.id = (SELECT max(id) FROM messages WHERE session_id = new.session_id) BEGIN
+  UPDATE sessions SET preview = substr(new.content, 1, 200) WHERE id = new.session_id;
+END;
+
+-- Summarize sessions that existed before this migration.
+UPDATE sessions SET
+  message_count = (SELECT count(*) FROM messages WHERE session_id = sessions.id),
+  last_message_at = (SELECT max(created_at) FROM messages WHERE session_id = sessions.id),
+  preview = coalesce((SELECT substr(content, 1, 200) FROM messages
+                      WHERE session_id = sessions.id ORDER BY id DESC LIMIT 1), '');
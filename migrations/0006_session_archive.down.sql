@@ -0,0 +1,4 @@
+-- openvim cold archive tier rollback
+-- Archive files under <data_dir>/archive are left in place.
+
+DROP TABLE IF EXISTS archived_sessions;
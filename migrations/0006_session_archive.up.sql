@@ -0,0 +1,11 @@
+-- openvim cold archive tier
+--
+-- Sessions idle past a threshold move, with their messages and blobs, into
+-- <data_dir>/archive/openvim-<period>.db. This table records which period
+-- file holds each one so lookups open only that file.
+
+CREATE TABLE IF NOT EXISTS archived_sessions (
+  id TEXT PRIMARY KEY,
+  period TEXT NOT NULL,
+  archived_at INTEGER NOT NULL
+);
@@ -8,15 +8,26 @@ namespace config {
 
 static void print_help(std::string_view prog) {
   std::cout << "openvim - a claude code alternative with no vendor lock-in\n\n";
-  std::cout << "Usage:\n  " << prog << " [flags]\n\n";
+  std::cout << "Usage:\n  " << prog << " [flags]\n";
+  std::cout << "  " << prog << " export [file] [flags]   Write all sessions as JSONL (default: stdout)\n";
+  std::cout << "  " << prog << " import [file] [flags]   Load sessions from JSONL (default: stdin)\n\n";
   std::cout << "Flags:\n";
   std::cout << "  -h, --help            Show help\n";
   std::cout << "  -d, --debug           Enable debug logging\n";
   std::cout << "      --test             Test mode (initialize GUI without showing)\n";
   std::cout << "      --data-dir <dir>  Data directory (default: .openvim)\n";
+  std::cout << "      --write-behind    Batch message writes on a background thread\n";
+  std::cout << "      --db-readers <n>  Read-only DB connections (default: 2)\n";
+  std::cout << "      --archive-after-days <n> Archive sessions idle n days at startup\n";
+  std::cout << "      --storage-profile <p> durable, balanced or fast (default: durable)\n";
+  std::cout << "      --wal-truncate-mb <n> Truncate the WAL past n MB, 0 = never (default: 64)\n";
   std::cout << "      --llm-api-key <key> LLM API key (can also set OPENAI_API_KEY env var)\n";
   std::cout << "      --llm-base-url <url> LLM base URL (default: https://api.openai.com/v1)\n";
   std::cout << "      --llm-model <model> LLM model (default: gpt-4)\n";
+  std::cout << "      --llm-no-stream   Wait for whole completions instead of streaming\n";
+  std::cout << "      --llm-connections <n> Keep-alive connections to the LLM endpoint (default: 4)\n";
+  std::cout << "      --llm-workers <n> Threads running LLM turns (default: 4)\n";
+  std::cout << "      --llm-max-in-flight <n> Concurrent LLM API calls (default: 4)\n";
 }
 
 Config parse_args_or_exit(int argc, char** argv) {
@@ -31,6 +42,16 @@ Config parse_args_or_exit(int argc, char** argv) {
       std::exit(0);
     }
 
+    if (i == 1 && (arg == "export" || arg == "import")) {
+      cfg.mode = arg;
+      continue;
+    }
+
+    if (!cfg.mode.empty() && cfg.transfer_path.empty() && (arg == "-" || !arg.starts_with("-"))) {
+      if (arg != "-") cfg.transfer_path = arg;
+      continue;
+    }
+
     if (arg == "-d" || arg == "--debug") {
       cfg.debug = true;
       continue;
@@ -50,6 +71,55 @@ Config parse_args_or_exit(int argc, char** argv) {
       continue;
     }
 
+    if (arg == "--write-behind") {
+      cfg.write_behind = true;
+      continue;
+    }
+
+    if (arg == "--db-readers") {
+      if (i + 1 >= argc) {
+        std::cerr << "--db-readers requires a value\n";
+        std::exit(2);
+      }
+      cfg.db_readers = std::atoi(argv[++i]);
+      if (cfg.db_readers < 0) cfg.db_readers = 0;
+      continue;
+    }
+
+    if (arg == "--archive-after-days") {
+      if (i + 1 >= argc) {
+        std::cerr << "--archive-after-days requires a value\n";
+        std::exit(2);
+      }
+      cfg.archive_after_days = std::atoi(argv[++i]);
+      if (cfg.archive_after_days < 0) cfg.archive_after_days = 0;
+      continue;
+    }
+
+    if (arg == "--storage-profile") {
+      if (i + 1 >= argc) {
+        std::cerr << "--storage-profile requires a value\n";
+        std::exit(2);
+      }
+      cfg.storage_profile = argv[++i];
+      if (cfg.storage_profile != "durable" && cfg.storage_profile != "balanced" &&
+          cfg.storage_profile != "fast") {
+        std::cerr << "--storage-profile must be durable, balanced or fast\n";
+        std::exit(2);
+      }
+      continue;
+    }
+
+    if (arg == "--wal-truncate-mb") {
+      if (i + 1 >= argc) {
+        std::cerr << "--wal-truncate-mb requires a value\n";
+        std::exit(2);
+      }
+      cfg.wal_truncate_mb = std::atoi(argv[++i]);
+      if (cfg.wal_truncate_mb < 0) cfg.wal_truncate_mb = 0;
+      continue;
+    }
+
     if (arg == "--llm-api-key") {
       if (i + 1 >= argc) {
         std::cerr << "--llm-api-key requires a value\n";
@@ -77,6 +147,41 @@ Config parse_args_or_exit(int argc, char** argv) {
       continue;
     }
 
+    if (arg == "--llm-connections") {
+      if (i + 1 >= argc) {
+        std::cerr << "--llm-connections requires a value\n";
+        std::exit(2);
+      }
+      cfg.llm_connections = std::atoi(argv[++i]);
+      if (cfg.llm_connections < 1) cfg.llm_connections = 1;
+      continue;
+    }
+
+    if (arg == "--llm-workers") {
+      if (i + 1 >= argc) {
+        std::cerr << "--llm-workers requires a value\n";
+        std::exit(2);
+      }
+      cfg.llm_workers = std::atoi(argv[++i]);
+      if (cfg.llm_workers < 1) cfg.llm_workers = 1;
+      continue;
+    }
+
+    if (arg == "--llm-max-in-flight") {
+      if (i + 1 >= argc) {
+        std::cerr << "--llm-max-in-flight requires a value\n";
+        std::exit(2);
+      }
+      cfg.llm_max_in_flight = std::atoi(argv[++i]);
+      if (cfg.llm_max_in_flight < 1) cfg.llm_max_in_flight = 1;
+      continue;
+    }
+
+    if (arg == "--llm-no-stream") {
+      cfg.llm_stream = false;
+      continue;
+    }
+
     std::cerr << "Unknown argument: " << arg << "\n";
     print_help(prog);
     std::exit(2);
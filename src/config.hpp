@@ -22,9 +22,25 @@ struct MCPServer {
 };
 
 struct Config {
+  // "export" or "import" when given as the first argument; empty runs the app.
+  std::string mode;
+  // JSONL file for export/import; empty means stdout/stdin.
+  std::string transfer_path;
   bool debug = false;
   bool test_mode = false;
   std::string data_dir = ".openvim";
+  // Commit message inserts from a background thread in batches.
+  bool write_behind = false;
+  // Read-only connections opened alongside the writer.
+  int db_readers = 2;
+  // Storage pragmas: durable, balanced or fast (see db::tuning_profile). The
+  // default keeps synchronous = FULL, as before profiles existed; balanced
+  // trades the last commits on power loss for speed.
+  std::string storage_profile = "durable";
+  // Background TRUNCATE checkpoint once the WAL grows past this; 0 disables.
+  int wal_truncate_mb = 64;
+  // Archive sessions idle this many days at startup; 0 disables.
+  int archive_after_days = 0;
   std::vector<MCPServer> mcp_servers;
   
   // LLM configuration
@@ -33,6 +49,13 @@ struct Config {
   std::string llm_model = "gpt-4";
   int llm_max_tokens = 4096;
   double llm_temperature = 0.7;
+  // Request completions with stream: true and publish tokens as they arrive.
+  bool llm_stream = true;
+  // Keep-alive connections held open to the LLM endpoint.
+  int llm_connections = 4;
+  // Threads running LLM turns, and the cap on API calls in flight at once.
+  int llm_workers = 4;
+  int llm_max_in_flight = 4;
 };
 
 // Parses argv for commit-4-equivalent flags.
@@ -0,0 +1,259 @@
+#include "db/archive.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <stdexcept>
+
+namespace db {
+
+// Same columns as the hot tables (summaries included) minus the FTS index, its
+// seq key, triggers and blob refcounts: archived rows are only copied in and
+// out.
+static const char* k_archive_schema =
+    "CREATE TABLE IF NOT EXISTS archive.sessions ("
+    "  id TEXT PRIMARY KEY, title TEXT NOT NULL, created_at INTEGER NOT NULL,"
+    "  message_count INTEGER NOT NULL DEFAULT 0, last_message_at INTEGER,"
+    "  preview TEXT NOT NULL DEFAULT '');"
+    "CREATE TABLE IF NOT EXISTS archive.messages ("
+    "  id TEXT PRIMARY KEY, session_id TEXT NOT NULL, role TEXT NOT NULL,"
+    "  content TEXT NOT NULL, created_at INTEGER NOT NULL, blob_hash TEXT);"
+    "CREATE INDEX IF NOT EXISTS archive.idx_messages_session_id ON messages(session_id, id);"
+    "CREATE TABLE IF NOT EXISTS archive.blobs ("
+    "  hash TEXT PRIMARY KEY, size INTEGER NOT NULL, encoding TEXT NOT NULL);"
+    "CREATE TABLE IF NOT EXISTS archive.blob_data ("
+    "  hash TEXT PRIMARY KEY, data BLOB NOT NULL);";
+
+// Attaches an archive file as schema "archive" for the guard's lifetime.
+class Attached {
+ public:
+  Attached(Db& db, const std::string& path) : db_(db) {
+    auto stmt = db.prepare("ATTACH DATABASE ? AS archive;");
+    sqlite3_bind_text(stmt, 1, path.c_str(), -1, SQLITE_TRANSIENT);
+    if (sqlite3_step(stmt) != SQLITE_DONE) throw std::runtime_error(sqlite3_errmsg(db.get()));
+  }
+  Attached(const Attached&) = delete;
+  Attached& operator=(const Attached&) = delete;
+  ~Attached() {
+    try {
+      db_.exec("DETACH DATABASE archive;");
+    } catch (...) {
+    }
+  }
+
+ private:
+  Db& db_;
+};
+
+// Runs a statement taking one text parameter (?1).
+static void run(Db& db, const char* sql, const std::string& arg) {
+  auto stmt = db.prepare(sql);
+  sqlite3_bind_text(stmt, 1, arg.c_str(), -1, SQLITE_TRANSIENT);
+  if (sqlite3_step(stmt) != SQLITE_DONE) throw std::runtime_error(sqlite3_errmsg(db.get()));
+}
+
+// Raises main's synchronous to FULL for the guard's lifetime, so a commit is
+// on disk before anything that depends on it.
+class SynchronousFull {
+ public:
+  explicit SynchronousFull(Db& db) : db_(db) {
+    auto stmt = db.prepare("PRAGMA main.synchronous;");
+    if (sqlite3_step(stmt) != SQLITE_ROW) throw std::runtime_error(sqlite3_errmsg(db.get()));
+    previous_ = sqlite3_column_int(stmt, 0);
+    stmt = {};
+    db.exec("PRAGMA main.synchronous = FULL;");
+  }
+  SynchronousFull(const SynchronousFull&) = delete;
+  SynchronousFull& operator=(const SynchronousFull&) = delete;
+  ~SynchronousFull() {
+    try {
+      db_.exec(("PRAGMA main.synchronous = " + std::to_string(previous_) + ";").c_str());
+    } catch (...) {
+    }
+  }
+
+ private:
+  Db& db_;
+  int previous_ = 2;
+};
+
+std::string archive_path(const std::string& data_dir, const std::string& period) {
+  namespace fs = std::filesystem;
+  return (fs::path(data_dir) / "archive" / ("openvim-" + period + ".db")).string();
+}
+
+// Moves the sessions in temp.archive_batch into the attached archive. In WAL
+// mode a transaction spanning two files is atomic per file only, so this is
+// two transactions that each write one file: the copy commits (with a full
+// fsync) before the hot rows are deleted. A crash in between leaves the
+// sessions in both places; the hot rows are still authoritative and the
+// OR REPLACE inserts overwrite the stale copy on the next run.
+static void move_batch(Db& db, const std::string& period) {
+  db.exec("BEGIN IMMEDIATE;");
+  try {
+    db.exec(
+        "INSERT OR REPLACE INTO archive.sessions "
+        "SELECT id, title, created_at, message_count, last_message_at, preview "
+        "FROM main.sessions WHERE id IN (SELECT id FROM temp.archive_batch);"
+        "INSERT OR REPLACE INTO archive.messages "
+        "SELECT id, session_id, role, content, created_at, blob_hash "
+        "FROM main.messages WHERE session_id IN (SELECT id FROM temp.archive_batch);"
+        "INSERT OR IGNORE INTO archive.blobs "
+        "SELECT hash, size, encoding FROM main.blobs WHERE hash IN ("
+        "  SELECT blob_hash FROM main.messages"
+        "  WHERE session_id IN (SELECT id FROM temp.archive_batch));"
+        "INSERT OR IGNORE INTO archive.blob_data "
+        "SELECT hash, data FROM main.blob_data WHERE hash IN ("
+        "  SELECT blob_hash FROM main.messages"
+        "  WHERE session_id IN (SELECT id FROM temp.archive_batch));");
+    db.exec("COMMIT;");
+  } catch (...) {
+    db.exec("ROLLBACK;");
+    throw;
+  }
+
+  db.exec("BEGIN IMMEDIATE;");
+  try {
+    auto now = std::chrono::duration_cast<std::chrono::seconds>(
+                   std::chrono::system_clock::now().time_since_epoch())
+                   .count();
+    {
+      auto stmt = db.prepare(
+          "INSERT OR REPLACE INTO main.archived_sessions(id, period, archived_at) "
+          "SELECT id, ?1, ?2 FROM temp.archive_batch;");
+      sqlite3_bind_text(stmt, 1, period.c_str(), -1, SQLITE_TRANSIENT);
+      sqlite3_bind_int64(stmt, 2, (sqlite3_int64)now);
+      if (sqlite3_step(stmt) != SQLITE_DONE) throw std::runtime_error(sqlite3_errmsg(db.get()));
+    }
+
+    // Cascades to messages; their triggers drop FTS entries and blob refs.
+    db.exec("DELETE FROM main.sessions WHERE id IN (SELECT id FROM temp.archive_batch);");
+    db.exec("COMMIT;");
+  } catch (...) {
+    db.exec("ROLLBACK;");
+    throw;
+  }
+}
+
+std::vector<std::string> archive_sessions(Db& db, const std::string& data_dir,
+                                          std::int64_t cutoff) {
+  namespace fs = std::filesystem;
+
+  // Range scan over idx_sessions_last_activity, grouped by month.
+  std::map<std::string, std::vector<std::string>> by_period;
+  {
+    auto stmt = db.prepare(
+        "SELECT id, strftime('%Y-%m', coalesce(last_message_at, created_at), 'unixepoch') "
+        "FROM sessions WHERE coalesce(last_message_at, created_at) < ?;");
+    sqlite3_bind_int64(stmt, 1, (sqlite3_int64)cutoff);
+    while (true) {
+      int rc = sqlite3_step(stmt);
+      if (rc == SQLITE_ROW) {
+        auto id = (const char*)sqlite3_column_text(stmt, 0);
+        auto period = (const char*)sqlite3_column_text(stmt, 1);
+        by_period[period ? period : "unknown"].push_back(id);
+        continue;
+      }
+      if (rc == SQLITE_DONE) break;
+      throw std::runtime_error(sqlite3_errmsg(db.get()));
+    }
+  }
+
+  std::vector<std::string> moved;
+  if (by_period.empty()) return moved;
+
+  fs::create_directories(fs::path(data_dir) / "archive");
+  db.exec("CREATE TEMP TABLE IF NOT EXISTS archive_batch (id TEXT PRIMARY KEY);");
+
+  for (const auto& [period, ids] : by_period) {
+    Attached attached(db, archive_path(data_dir, period));
+    // The copy must be durable before the hot rows go, whatever the main
+    // database's profile.
+    db.exec("PRAGMA archive.synchronous = FULL;");
+    db.exec(k_archive_schema);
+
+    db.exec("DELETE FROM temp.archive_batch;");
+    for (const auto& id : ids) run(db, "INSERT INTO temp.archive_batch(id) VALUES(?1);", id);
+    move_batch(db, period);
+
+    moved.insert(moved.end(), ids.begin(), ids.end());
+  }
+  db.exec("DELETE FROM temp.archive_batch;");
+
+  return moved;
+}
+
+bool restore_session(Db& db, const std::string& data_dir, const std::string& id) {
+  namespace fs = std::filesystem;
+
+  auto period = archived_period(db, id);
+  if (period.empty()) return false;
+
+  auto path = archive_path(data_dir, period);
+  if (!fs::exists(path)) throw std::runtime_error("archive file missing: " + path);
+  Attached attached(db, path);
+
+  // As in move_batch(), one transaction per file: the hot copy commits
+  // (durably, whatever the profile) first, then the archived one is deleted.
+  // A crash in between leaves a stale copy in the archive that nothing
+  // points to; archiving the session again overwrites it.
+  SynchronousFull durable(db);
+  // Blobs go in first with refcount 0; inserting the messages counts them.
+  // Summary columns are rebuilt by the message triggers as rows go back in.
+  db.exec("BEGIN IMMEDIATE;");
+  try {
+    run(db,
+        "INSERT OR IGNORE INTO main.blobs(hash, size, encoding, refcount) "
+        "SELECT hash, size, encoding, 0 FROM archive.blobs WHERE hash IN ("
+        "  SELECT blob_hash FROM archive.messages WHERE session_id = ?1);",
+        id);
+    run(db,
+        "INSERT OR IGNORE INTO main.blob_data(hash, data) "
+        "SELECT hash, data FROM archive.blob_data WHERE hash IN ("
+        "  SELECT blob_hash FROM archive.messages WHERE session_id = ?1);",
+        id);
+    run(db,
+        "INSERT INTO main.sessions(id, title, created_at) "
+        "SELECT id, title, created_at FROM archive.sessions WHERE id = ?1;",
+        id);
+    run(db,
+        "INSERT INTO main.messages(id, session_id, role, content, created_at, blob_hash) "
+        "SELECT id, session_id, role, content, created_at, blob_hash FROM archive.messages "
+        "WHERE session_id = ?1 ORDER BY id;",
+        id);
+    run(db, "DELETE FROM main.archived_sessions WHERE id = ?1;", id);
+    db.exec("COMMIT;");
+  } catch (...) {
+    db.exec("ROLLBACK;");
+    throw;
+  }
+
+  db.exec("BEGIN IMMEDIATE;");
+  try {
+    run(db, "DELETE FROM archive.messages WHERE session_id = ?1;", id);
+    run(db, "DELETE FROM archive.sessions WHERE id = ?1;", id);
+    db.exec(
+        "DELETE FROM archive.blob_data WHERE hash NOT IN ("
+        "  SELECT blob_hash FROM archive.messages WHERE blob_hash IS NOT NULL);"
+        "DELETE FROM archive.blobs WHERE hash NOT IN ("
+        "  SELECT blob_hash FROM archive.messages WHERE blob_hash IS NOT NULL);");
+    db.exec("COMMIT;");
+  } catch (...) {
+    db.exec("ROLLBACK;");
+    throw;
+  }
+
+  return true;
+}
+
+std::string archived_period(Db& db, const std::string& id) {
+  auto stmt = db.prepare("SELECT period FROM archived_sessions WHERE id = ? LIMIT 1;");
+  sqlite3_bind_text(stmt, 1, id.c_str(), -1, SQLITE_TRANSIENT);
+
+  int rc = sqlite3_step(stmt);
+  if (rc == SQLITE_ROW) return (const char*)sqlite3_column_text(stmt, 0);
+  if (rc == SQLITE_DONE) return {};
+  throw std::runtime_error(sqlite3_errmsg(db.get()));
+}
+
+}  // namespace db
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "db/db.hpp"
+
+namespace db {
+
+// Cold storage for idle sessions. A session whose last activity (newest
+// message, or creation if it has none) falls in month YYYY-MM lives, with its
+// messages and blobs, in <data_dir>/archive/openvim-YYYY-MM.db. The hot
+// database keeps only a row in archived_sessions naming the file.
+//
+// Archive files are attached to the writer only while moving sessions in or
+// out, so these must not run while another transaction is open on `db`; hold
+// the pool's Writer across the call.
+
+std::string archive_path(const std::string& data_dir, const std::string& period);
+
+// Moves every session last active before `cutoff` (unix seconds) into its
+// period's archive file and returns their ids.
+std::vector<std::string> archive_sessions(Db& db, const std::string& data_dir,
+                                          std::int64_t cutoff);
+
+// Moves an archived session and its messages back into the hot database.
+// Returns false if `id` isn't archived.
+bool restore_session(Db& db, const std::string& data_dir, const std::string& id);
+
+// The period whose archive file holds `id`, or empty if it isn't archived.
+std::string archived_period(Db& db, const std::string& id);
+
+}  // namespace db
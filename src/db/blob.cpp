@@ -0,0 +1,177 @@
+#include "db/blob.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "db/sha256.hpp"
+
+namespace db {
+
+static constexpr std::size_t k_chunk = 64 * 1024;
+
+std::string put_blob(Db& db, std::string_view content) {
+  return put_blob(db, content, sha256_hex(content));
+}
+
+std::string put_blob(Db& db, std::string_view content, const std::string& hash) {
+  // Already stored: skip compressing it again. The caller holds the writer,
+  // so nothing can insert the same hash between this check and the insert.
+  {
+    auto stmt = db.prepare("SELECT 1 FROM blobs WHERE hash = ?;");
+    sqlite3_bind_text(stmt, 1, hash.c_str(), -1, SQLITE_TRANSIENT);
+    int rc = sqlite3_step(stmt);
+    if (rc == SQLITE_ROW) return hash;
+    if (rc != SQLITE_DONE) throw std::runtime_error(sqlite3_errmsg(db.get()));
+  }
+  {
+    auto stmt = db.prepare("INSERT INTO blobs(hash, size, encoding) VALUES(?, ?, ?);");
+    sqlite3_bind_text(stmt, 1, hash.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int64(stmt, 2, (sqlite3_int64)content.size());
+    sqlite3_bind_text(stmt, 3, "zlib", -1, SQLITE_STATIC);
+    if (sqlite3_step(stmt) != SQLITE_DONE) throw std::runtime_error(sqlite3_errmsg(db.get()));
+  }
+
+  uLongf len = compressBound((uLong)content.size());
+  std::vector<unsigned char> packed(len);
+  int zrc = compress2(packed.data(), &len, (const Bytef*)content.data(), (uLong)content.size(),
+                      Z_DEFAULT_COMPRESSION);
+  bool use_zlib = zrc == Z_OK && len < content.size();
+
+  if (!use_zlib) {
+    const char* sql = "UPDATE blobs SET encoding = 'raw' WHERE hash = ?;";
+    auto stmt = db.prepare(sql);
+    sqlite3_bind_text(stmt, 1, hash.c_str(), -1, SQLITE_TRANSIENT);
+    if (sqlite3_step(stmt) != SQLITE_DONE) throw std::runtime_error(sqlite3_errmsg(db.get()));
+  }
+
+  const char* sql = "INSERT INTO blob_data(hash, data) VALUES(?, ?);";
+  auto stmt = db.prepare(sql);
+  sqlite3_bind_text(stmt, 1, hash.c_str(), -1, SQLITE_TRANSIENT);
+  if (use_zlib) {
+    sqlite3_bind_blob64(stmt, 2, packed.data(), len, SQLITE_STATIC);
+  } else {
+    sqlite3_bind_blob64(stmt, 2, content.data(), content.size(), SQLITE_STATIC);
+  }
+  if (sqlite3_step(stmt) != SQLITE_DONE) throw std::runtime_error(sqlite3_errmsg(db.get()));
+
+  return hash;
+}
+
+std::string read_blob(Db& db, const std::string& hash) {
+  const char* sql =
+      "SELECT b.size, b.encoding, d.data FROM blobs b JOIN blob_data d ON d.hash = b.hash "
+      "WHERE b.hash = ?;";
+  auto stmt = db.prepare(sql);
+  sqlite3_bind_text(stmt, 1, hash.c_str(), -1, SQLITE_TRANSIENT);
+  if (sqlite3_step(stmt) != SQLITE_ROW) throw std::runtime_error("blob not found: " + hash);
+
+  auto size = (std::size_t)sqlite3_column_int64(stmt, 0);
+  auto enc = (const char*)sqlite3_column_text(stmt, 1);
+  auto data = (const Bytef*)sqlite3_column_blob(stmt, 2);
+  auto stored = (uLong)sqlite3_column_bytes(stmt, 2);
+
+  if (!(enc && std::string(enc) == "zlib")) return std::string((const char*)data, stored);
+
+  std::string out(size, '\0');
+  uLongf len = (uLongf)size;
+  if (uncompress((Bytef*)out.data(), &len, data, stored) != Z_OK) {
+    throw std::runtime_error("corrupt blob data");
+  }
+  out.resize(len);
+  return out;
+}
+
+BlobReader::BlobReader(Reader db, const std::string& hash) : db_(std::move(db)) {
+  sqlite3_int64 rowid = 0;
+  {
+    const char* sql =
+        "SELECT d.rowid, b.size, b.encoding FROM blobs b JOIN blob_data d ON d.hash = b.hash "
+        "WHERE b.hash = ?;";
+    auto stmt = db_->prepare(sql);
+    sqlite3_bind_text(stmt, 1, hash.c_str(), -1, SQLITE_TRANSIENT);
+    if (sqlite3_step(stmt) != SQLITE_ROW) throw std::runtime_error("blob not found: " + hash);
+    rowid = sqlite3_column_int64(stmt, 0);
+    size_ = (std::size_t)sqlite3_column_int64(stmt, 1);
+    auto enc = (const char*)sqlite3_column_text(stmt, 2);
+    compressed_ = enc && std::string(enc) == "zlib";
+  }
+
+  if (sqlite3_blob_open(db_->get(), "main", "blob_data", "data", rowid, 0, &blob_) != SQLITE_OK) {
+    std::string msg = sqlite3_errmsg(db_->get());
+    if (blob_) sqlite3_blob_close(blob_);
+    throw std::runtime_error(msg);
+  }
+  stored_ = sqlite3_blob_bytes(blob_);
+
+  if (compressed_) {
+    if (inflateInit(&zs_) != Z_OK) {
+      sqlite3_blob_close(blob_);
+      throw std::runtime_error("inflateInit failed");
+    }
+    zs_init_ = true;
+    in_.resize(k_chunk);
+  }
+}
+
+BlobReader::~BlobReader() {
+  if (zs_init_) inflateEnd(&zs_);
+  if (blob_) sqlite3_blob_close(blob_);
+}
+
+// Refills in_ from the row; false once the row is exhausted.
+bool BlobReader::fill() {
+  if (offset_ >= stored_) return false;
+  int n = std::min((int)in_.size(), stored_ - offset_);
+  if (sqlite3_blob_read(blob_, in_.data(), n, offset_) != SQLITE_OK) {
+    throw std::runtime_error(sqlite3_errmsg(db_->get()));
+  }
+  offset_ += n;
+  zs_.next_in = in_.data();
+  zs_.avail_in = (uInt)n;
+  return true;
+}
+
+std::size_t BlobReader::read(char* buf, std::size_t n) {
+  if (done_ || n == 0) return 0;
+
+  if (!compressed_) {
+    int len = (int)std::min<std::size_t>(n, (std::size_t)(stored_ - offset_));
+    if (len <= 0) {
+      done_ = true;
+      return 0;
+    }
+    if (sqlite3_blob_read(blob_, buf, len, offset_) != SQLITE_OK) {
+      throw std::runtime_error(sqlite3_errmsg(db_->get()));
+    }
+    offset_ += len;
+    return (std::size_t)len;
+  }
+
+  zs_.next_out = (Bytef*)buf;
+  zs_.avail_out = (uInt)std::min<std::size_t>(n, UINT32_MAX);
+  while (zs_.avail_out > 0) {
+    if (zs_.avail_in == 0 && !fill()) break;
+    int rc = inflate(&zs_, Z_NO_FLUSH);
+    if (rc == Z_STREAM_END) {
+      done_ = true;
+      break;
+    }
+    if (rc != Z_OK) throw std::runtime_error("corrupt blob data");
+  }
+  return n - zs_.avail_out;
+}
+
+std::string BlobReader::read_all() {
+  std::string out;
+  out.resize(size_);
+  std::size_t got = 0;
+  while (got < out.size()) {
+    auto n = read(out.data() + got, out.size() - got);
+    if (n == 0) break;
+    got += n;
+  }
+  out.resize(got);
+  return out;
+}
+
+}  // namespace db
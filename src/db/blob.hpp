@@ -0,0 +1,62 @@
+#pragma once
+
+#include <sqlite3.h>
+#include <zlib.h>
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "db/pool.hpp"
+
+namespace db {
+
+// Stores content in the blobs table (zlib-compressed when that helps) unless a
+// blob with the same SHA-256 already exists, and returns the hash. Does not
+// touch refcounts: inserting a message with blob_hash set does that.
+// Call inside the same transaction/savepoint as that message insert, while
+// holding the pool's Writer for all of it.
+std::string put_blob(Db& db, std::string_view content);
+// Same, for a caller that already has sha256_hex(content).
+std::string put_blob(Db& db, std::string_view content, const std::string& hash);
+
+// Loads a whole blob, decompressed, using `db` directly. For callers already
+// holding a connection (bulk export); prefer BlobReader for large payloads.
+// Throws std::runtime_error if no blob has this hash.
+std::string read_blob(Db& db, const std::string& hash);
+
+// Streams a blob's decompressed bytes without loading it whole. Holds its read
+// connection until destroyed.
+class BlobReader {
+ public:
+  // Throws std::runtime_error if no blob has this hash.
+  BlobReader(Reader db, const std::string& hash);
+  BlobReader(const BlobReader&) = delete;
+  BlobReader& operator=(const BlobReader&) = delete;
+  ~BlobReader();
+
+  // Uncompressed size in bytes.
+  std::size_t size() const { return size_; }
+
+  // Fills up to n bytes of buf; returns how many, 0 at the end.
+  std::size_t read(char* buf, std::size_t n);
+
+  std::string read_all();
+
+ private:
+  bool fill();
+
+  Reader db_;
+  sqlite3_blob* blob_ = nullptr;
+  std::size_t size_ = 0;
+  bool compressed_ = false;
+  int stored_ = 0;  // compressed bytes in the row
+  int offset_ = 0;  // next byte of the row to read
+  std::vector<unsigned char> in_;
+  z_stream zs_{};
+  bool zs_init_ = false;
+  bool done_ = false;
+};
+
+}  // namespace db
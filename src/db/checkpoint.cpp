@@ -0,0 +1,133 @@
+#include "db/checkpoint.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <stdexcept>
+#include <system_error>
+
+namespace db {
+
+static std::string db_path(const std::string& data_dir) {
+  namespace fs = std::filesystem;
+  return (fs::path(data_dir) / "openvim.db").string();
+}
+
+static Db open_checkpoint_conn(const std::string& path, std::chrono::milliseconds busy) {
+  sqlite3* raw = nullptr;
+  int rc = sqlite3_open_v2(path.c_str(), &raw, SQLITE_OPEN_READWRITE | SQLITE_OPEN_NOMUTEX,
+                           nullptr);
+  if (rc != SQLITE_OK) {
+    std::string msg = raw ? sqlite3_errmsg(raw) : "sqlite3_open_v2 failed";
+    if (raw) sqlite3_close(raw);
+    throw std::runtime_error(msg);
+  }
+  sqlite3_busy_timeout(raw, (int)busy.count());
+  return Db(raw);
+}
+
+static std::string megabytes(std::uintmax_t bytes) {
+  char buf[32];
+  std::snprintf(buf, sizeof(buf), "%.1f MB", (double)bytes / (1024.0 * 1024.0));
+  return buf;
+}
+
+Checkpointer::Checkpointer(Pool& pool, CheckpointPolicy policy, logging::Logger& log)
+    : pool_(pool),
+      conn_(open_checkpoint_conn(db_path(pool.data_dir()), policy.busy_timeout)),
+      wal_path_(db_path(pool.data_dir()) + "-wal"),
+      policy_(policy),
+      log_(log) {
+  pool_.writer()->exec("PRAGMA wal_autocheckpoint = 0;");
+  thread_ = std::thread(&Checkpointer::loop, this);
+}
+
+Checkpointer::~Checkpointer() {
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    stopping_ = true;
+  }
+  cv_.notify_one();
+  thread_.join();
+
+  try {
+    pool_.writer()->exec("PRAGMA wal_autocheckpoint = 1000;");
+  } catch (...) {
+  }
+}
+
+// Changes whenever another connection commits.
+static std::int64_t data_version(Db& db) {
+  auto stmt = db.prepare("PRAGMA data_version;");
+  if (sqlite3_step(stmt) != SQLITE_ROW) throw std::runtime_error(sqlite3_errmsg(db.get()));
+  return sqlite3_column_int64(stmt, 0);
+}
+
+void Checkpointer::loop() {
+  std::int64_t last_version = 0;
+  // Whatever is in the WAL at startup is worth checkpointing once idle.
+  bool dirty = true;
+
+  std::unique_lock<std::mutex> lk(mu_);
+  while (true) {
+    cv_.wait_for(lk, policy_.interval, [&] { return stopping_; });
+    if (stopping_) return;
+    lk.unlock();
+
+    try {
+      auto version = data_version(conn_);
+      bool idle = version == last_version;
+      last_version = version;
+      if (!idle) dirty = true;
+
+      std::error_code ec;
+      auto wal_bytes = std::filesystem::file_size(wal_path_, ec);
+      if (ec) wal_bytes = 0;
+
+      // The WAL file keeps its size after a PASSIVE checkpoint (it is reused
+      // from the start), so its size only means growth if there were commits.
+      if (dirty && policy_.truncate_bytes > 0 && wal_bytes > policy_.truncate_bytes) {
+        dirty = !checkpoint(SQLITE_CHECKPOINT_TRUNCATE, wal_bytes);
+      } else if (dirty && idle && policy_.passive_on_idle) {
+        dirty = !checkpoint(SQLITE_CHECKPOINT_PASSIVE, wal_bytes);
+      }
+    } catch (const std::exception& e) {
+      log_.warn(std::string("WAL checkpoint failed: ") + e.what());
+    }
+
+    lk.lock();
+  }
+}
+
+bool Checkpointer::checkpoint(int mode, std::uintmax_t wal_bytes) {
+  const char* name = mode == SQLITE_CHECKPOINT_TRUNCATE ? "truncate" : "passive";
+
+  auto start = std::chrono::steady_clock::now();
+  int frames = 0;
+  int done = 0;
+  int rc = sqlite3_wal_checkpoint_v2(conn_.get(), "main", mode, &frames, &done);
+  auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start)
+                .count();
+
+  if (rc != SQLITE_OK && rc != SQLITE_BUSY) throw std::runtime_error(sqlite3_errmsg(conn_.get()));
+
+  // A completed TRUNCATE reports 0 frames: the log is already empty.
+  auto text = std::string("WAL checkpoint (") + name + "): ";
+  if (mode == SQLITE_CHECKPOINT_PASSIVE || rc == SQLITE_BUSY) {
+    text += std::to_string(done) + "/" + std::to_string(frames) + " frames, ";
+  }
+  text += "WAL " + megabytes(wal_bytes) + ", " + std::to_string(ms) + " ms";
+
+  if (rc == SQLITE_BUSY) {
+    log_.warn(text + ", blocked by other connections; will retry");
+    return false;
+  }
+  if (mode == SQLITE_CHECKPOINT_TRUNCATE) {
+    log_.info(text);
+  } else if (frames > 0) {
+    log_.debug(text);
+  }
+  return done == frames;
+}
+
+}  // namespace db
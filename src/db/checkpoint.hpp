@@ -0,0 +1,56 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "db/pool.hpp"
+#include "logging/logger.hpp"
+
+namespace db {
+
+struct CheckpointPolicy {
+  // How often the WAL is looked at.
+  std::chrono::milliseconds interval{1000};
+  // Run a PASSIVE checkpoint once a full interval passes with no commits.
+  bool passive_on_idle = true;
+  // Run a TRUNCATE checkpoint, which waits up to busy_timeout for readers and
+  // resets the WAL to zero bytes, once the WAL file exceeds this. 0 disables.
+  std::size_t truncate_bytes = 64 * 1024 * 1024;
+  std::chrono::milliseconds busy_timeout{500};
+};
+
+// Checkpoints the pool's <data_dir>/openvim.db from a background thread on its own
+// connection, so commits on the writer never pay for one inline. Turns off
+// the writer's auto-checkpoint for its lifetime. Each checkpoint is logged
+// with its mode, frame counts, WAL size and duration.
+class Checkpointer {
+ public:
+  Checkpointer(Pool& pool, CheckpointPolicy policy, logging::Logger& log);
+  ~Checkpointer();
+
+  Checkpointer(const Checkpointer&) = delete;
+  Checkpointer& operator=(const Checkpointer&) = delete;
+
+ private:
+  void loop();
+  // True if every frame in the WAL was checkpointed.
+  bool checkpoint(int mode, std::uintmax_t wal_bytes);
+
+  Pool& pool_;
+  Db conn_;
+  std::string wal_path_;
+  CheckpointPolicy policy_;
+  logging::Logger& log_;
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  bool stopping_ = false;
+  std::thread thread_;
+};
+
+}  // namespace db
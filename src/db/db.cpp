@@ -1,30 +1,92 @@
 #include "db/db.hpp"
 
 #include <filesystem>
+#include <mutex>
 #include <stdexcept>
-#include <unistd.h>
-#include <limits.h>
+#include <unordered_map>
 
 #include "db/migrate.hpp"
 
 namespace db {
 
-Db::Db(sqlite3* handle) : db_(handle) {}
+// Idle statements keyed by their SQL text. A multimap so that nested or
+// concurrent users of the same query each get their own statement.
+struct StmtCache {
+  std::mutex mu;
+  std::unordered_multimap<std::string, sqlite3_stmt*> idle;
 
-Db::Db(Db&& other) noexcept : db_(other.db_) { other.db_ = nullptr; }
+  ~StmtCache() {
+    for (auto& [_, stmt] : idle) sqlite3_finalize(stmt);
+  }
+};
+
+Stmt::Stmt(Stmt&& other) noexcept : cache_(other.cache_), stmt_(other.stmt_) {
+  other.cache_ = nullptr;
+  other.stmt_ = nullptr;
+}
+
+Stmt& Stmt::operator=(Stmt&& other) noexcept {
+  if (this == &other) return *this;
+  release();
+  cache_ = other.cache_;
+  stmt_ = other.stmt_;
+  other.cache_ = nullptr;
+  other.stmt_ = nullptr;
+  return *this;
+}
+
+Stmt::~Stmt() { release(); }
+
+void Stmt::release() {
+  if (!stmt_) return;
+  sqlite3_reset(stmt_);
+  sqlite3_clear_bindings(stmt_);
+  {
+    std::lock_guard<std::mutex> lk(cache_->mu);
+    cache_->idle.emplace(sqlite3_sql(stmt_), stmt_);
+  }
+  stmt_ = nullptr;
+  cache_ = nullptr;
+}
+
+Db::Db(sqlite3* handle) : db_(handle), cache_(std::make_unique<StmtCache>()) {}
+
+Db::Db(Db&& other) noexcept : db_(other.db_), cache_(std::move(other.cache_)) { other.db_ = nullptr; }
 
 Db& Db::operator=(Db&& other) noexcept {
   if (this == &other) return *this;
+  cache_.reset();
   if (db_) sqlite3_close(db_);
   db_ = other.db_;
+  cache_ = std::move(other.cache_);
   other.db_ = nullptr;
   return *this;
 }
 
 Db::~Db() {
+  // Cached statements must be finalized before the connection can close.
+  cache_.reset();
   if (db_) sqlite3_close(db_);
 }
 
+Stmt Db::prepare(const char* sql) {
+  {
+    std::lock_guard<std::mutex> lk(cache_->mu);
+    auto it = cache_->idle.find(sql);
+    if (it != cache_->idle.end()) {
+      auto* stmt = it->second;
+      cache_->idle.erase(it);
+      return Stmt(cache_.get(), stmt);
+    }
+  }
+
+  sqlite3_stmt* stmt = nullptr;
+  if (sqlite3_prepare_v3(db_, sql, -1, SQLITE_PREPARE_PERSISTENT, &stmt, nullptr) != SQLITE_OK) {
+    throw std::runtime_error(sqlite3_errmsg(db_));
+  }
+  return Stmt(cache_.get(), stmt);
+}
+
 static void exec(sqlite3* db, const char* sql) {
   char* err = nullptr;
   int rc = sqlite3_exec(db, sql, nullptr, nullptr, &err);
@@ -35,7 +97,25 @@ static void exec(sqlite3* db, const char* sql) {
   }
 }
 
-Db connect(const std::string& data_dir) {
+void Db::exec(const char* sql) { db::exec(db_, sql); }
+
+std::optional<Tuning> tuning_profile(std::string_view name) {
+  if (name == "durable") return Tuning{"FULL", 2000, 0, "DEFAULT"};
+  if (name == "balanced") return Tuning{"NORMAL", 16 * 1024, 64ll << 20, "DEFAULT"};
+  if (name == "fast") return Tuning{"OFF", 64 * 1024, 256ll << 20, "MEMORY"};
+  return std::nullopt;
+}
+
+static void apply_tuning(sqlite3* db, const Tuning& t, bool writer) {
+  std::string sql;
+  if (writer) sql += "PRAGMA synchronous = " + t.synchronous + ";";
+  sql += "PRAGMA cache_size = -" + std::to_string(t.cache_kib) + ";";
+  sql += "PRAGMA mmap_size = " + std::to_string(t.mmap_bytes) + ";";
+  sql += "PRAGMA temp_store = " + t.temp_store + ";";
+  exec(db, sql.c_str());
+}
+
+Db connect(const std::string& data_dir, const Tuning& tuning) {
   namespace fs = std::filesystem;
 
   fs::create_directories(fs::path(data_dir));
@@ -49,27 +129,44 @@ Db connect(const std::string& data_dir) {
     throw std::runtime_error(msg);
   }
 
+  // The background checkpointer's TRUNCATE briefly holds the write lock;
+  // wait for it instead of failing with SQLITE_BUSY.
+  sqlite3_busy_timeout(raw, 5000);
+
   // Basic pragmas (lightweight subset of Go's pragmas)
   exec(raw, "PRAGMA foreign_keys = ON;");
   exec(raw, "PRAGMA journal_mode = WAL;");
+  apply_tuning(raw, tuning, true);
 
-  // Apply SQL migrations from ./migrations
-  // (commit-style parity with the Go repo, which uses migration files)
-  // Use path relative to executable location
-  std::string migrations_path = "../migrations";
-  if (!fs::exists(migrations_path)) {
-    // Try relative to executable if ../migrations doesn't exist
-    char exe_path[PATH_MAX];
-    ssize_t len = readlink("/proc/self/exe", exe_path, sizeof(exe_path)-1);
-    if (len != -1) {
-      exe_path[len] = '\0';
-      fs::path exe_dir = fs::path(exe_path).parent_path();
-      migrations_path = (exe_dir / ".." / "migrations").string();
-    }
+  apply_migrations(raw);
+
+  return Db(raw);
+}
+
+static Db open_readonly(const std::string& path) {
+  sqlite3* raw = nullptr;
+  int rc = sqlite3_open_v2(path.c_str(), &raw, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX,
+                           nullptr);
+  if (rc != SQLITE_OK) {
+    std::string msg = raw ? sqlite3_errmsg(raw) : "sqlite3_open_v2 failed";
+    if (raw) sqlite3_close(raw);
+    throw std::runtime_error(msg);
   }
-  apply_migrations(raw, migrations_path);
+
+  sqlite3_busy_timeout(raw, 5000);
+  exec(raw, "PRAGMA query_only = ON;");
 
   return Db(raw);
 }
 
+Db connect_reader(const std::string& data_dir, const Tuning& tuning) {
+  namespace fs = std::filesystem;
+
+  auto db = open_readonly((fs::path(data_dir) / "openvim.db").string());
+  apply_tuning(db.get(), tuning, false);
+  return db;
+}
+
+Db connect_archive(const std::string& path) { return open_readonly(path); }
+
 }  // namespace db
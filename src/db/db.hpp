@@ -2,10 +2,40 @@
 
 #include <sqlite3.h>
 
+#include <cstdint>
+#include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 
 namespace db {
 
+struct StmtCache;
+
+// A prepared statement checked out of Db's statement cache. On destruction it is
+// reset, its bindings are cleared, and it goes back to the cache for reuse.
+// Must not outlive the Db it came from.
+class Stmt {
+ public:
+  Stmt() = default;
+  Stmt(const Stmt&) = delete;
+  Stmt& operator=(const Stmt&) = delete;
+  Stmt(Stmt&& other) noexcept;
+  Stmt& operator=(Stmt&& other) noexcept;
+  ~Stmt();
+
+  sqlite3_stmt* get() const { return stmt_; }
+  operator sqlite3_stmt*() const { return stmt_; }
+
+ private:
+  friend class Db;
+  Stmt(StmtCache* cache, sqlite3_stmt* stmt) : cache_(cache), stmt_(stmt) {}
+  void release();
+
+  StmtCache* cache_ = nullptr;
+  sqlite3_stmt* stmt_ = nullptr;
+};
+
 class Db {
  public:
   Db() = default;
@@ -19,11 +49,44 @@ class Db {
   sqlite3* get() const { return db_; }
   explicit operator bool() const { return db_ != nullptr; }
 
+  // Returns a cached statement for this exact SQL text, compiling it only the
+  // first time (or when every cached copy is already checked out).
+  // Throws std::runtime_error if the SQL does not compile.
+  Stmt prepare(const char* sql);
+
+  // Runs one or more statements without results. Throws std::runtime_error.
+  void exec(const char* sql);
+
  private:
   sqlite3* db_ = nullptr;
+  std::unique_ptr<StmtCache> cache_;
+};
+
+// Per-connection storage pragmas. The defaults are SQLite's own (what
+// openvim used before profiles existed).
+struct Tuning {
+  std::string synchronous = "FULL";  // OFF, NORMAL or FULL; writer only
+  std::int64_t cache_kib = 2000;
+  std::int64_t mmap_bytes = 0;
+  std::string temp_store = "DEFAULT";  // DEFAULT, FILE or MEMORY
 };
 
+// Named presets:
+//   durable   synchronous=FULL, 2 MiB cache, no mmap (the default, same as Tuning{})
+//   balanced  synchronous=NORMAL (may lose the last commits on power loss,
+//             never corrupts), 16 MiB cache, 64 MiB mmap
+//   fast      synchronous=OFF, 64 MiB cache, 256 MiB mmap, temp tables in memory
+std::optional<Tuning> tuning_profile(std::string_view name);
+
 // Opens (and creates) the DB at <data_dir>/openvim.db, ensures schema exists.
-Db connect(const std::string& data_dir);
+Db connect(const std::string& data_dir, const Tuning& tuning = {});
+
+// Opens an existing <data_dir>/openvim.db read-only for use by one thread at a
+// time (no SQLite connection mutex). Call connect() first to create the schema.
+Db connect_reader(const std::string& data_dir, const Tuning& tuning = {});
+
+// Opens an archive file written by archive_sessions() (see db/archive.hpp)
+// read-only, for use by one thread at a time.
+Db connect_archive(const std::string& path);
 
 }  // namespace db
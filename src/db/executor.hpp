@@ -0,0 +1,56 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+namespace db {
+
+// A single thread that runs database work in submission order, so callers on
+// latency-sensitive threads (UI rendering) hand off queries instead of
+// blocking on SQLite. The async_* service methods submit here.
+class Executor {
+ public:
+  Executor();
+  ~Executor();
+
+  Executor(const Executor&) = delete;
+  Executor& operator=(const Executor&) = delete;
+
+  // Runs f on the executor thread. The future carries its result or exception.
+  template <typename F>
+  std::future<std::invoke_result_t<F>> submit(F f) {
+    using R = std::invoke_result_t<F>;
+    auto task = std::make_shared<std::packaged_task<R()>>(std::move(f));
+    auto fut = task->get_future();
+    post([task] { (*task)(); });
+    return fut;
+  }
+
+  // Runs fn on the executor thread; fn must not throw.
+  void post(std::function<void()> fn);
+
+  // Blocks until everything submitted so far has run. Must not be called
+  // from the executor thread.
+  void drain();
+
+  bool on_executor_thread() const { return std::this_thread::get_id() == thread_.get_id(); }
+
+ private:
+  void loop();
+
+  std::mutex mu_;
+  std::condition_variable work_cv_;
+  std::condition_variable idle_cv_;
+  std::deque<std::function<void()>> queue_;
+  bool busy_ = false;
+  bool stopping_ = false;
+  std::thread thread_;
+};
+
+}  // namespace db
@@ -0,0 +1,59 @@
+#include "db/id.hpp"
+
+#include <chrono>
+#include <cstdio>
+
+namespace db {
+
+std::string new_id() {
+  static IdGenerator gen;
+  auto now = (std::uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+                 std::chrono::system_clock::now().time_since_epoch())
+                 .count();
+  return gen.next(now);
+}
+
+std::string IdGenerator::next(std::uint64_t now_ms) {
+  std::uint64_t ms;
+  std::uint32_t s;
+  std::uint64_t tail;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (now_ms > last_ms_) {
+      last_ms_ = now_ms;
+      seq_ = 0;
+    } else if (++seq_ > 0xffff) {
+      // Sequence exhausted (or the clock went back): borrow the next millisecond.
+      last_ms_++;
+      seq_ = 0;
+    }
+    ms = last_ms_;
+    s = seq_;
+    tail = rng_();
+  }
+
+  char buf[33];
+  std::snprintf(buf, sizeof(buf), "%012llx%04x%016llx", (unsigned long long)(ms & 0xffffffffffffULL),
+                (unsigned)s, (unsigned long long)tail);
+  return std::string(buf);
+}
+
+std::int64_t id_time_ms(const std::string& id) {
+  if (id.size() < 12) return 0;
+  std::int64_t ms = 0;
+  for (int i = 0; i < 12; i++) {
+    char c = id[i];
+    int v;
+    if (c >= '0' && c <= '9') {
+      v = c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+      v = c - 'a' + 10;
+    } else {
+      return 0;
+    }
+    ms = (ms << 4) | v;
+  }
+  return ms;
+}
+
+}  // namespace db
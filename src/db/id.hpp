@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <string>
+
+namespace db {
+
+// 32 lowercase hex chars: 48-bit Unix milliseconds, a 16-bit sequence, then
+// 64 random bits (UUIDv7-style). IDs from this process sort in creation
+// order, so primary-key inserts append to the B-tree and ORDER BY id is
+// exact; the sequence keeps them increasing within one millisecond.
+std::string new_id();
+
+// The state behind new_id(), with the clock passed in so tests can hold it
+// still or turn it back.
+class IdGenerator {
+ public:
+  // An id for wall-clock millisecond now_ms, greater than every id this
+  // generator returned before. When now_ms hasn't advanced the sequence
+  // counts up; past 0xffff it borrows the next millisecond.
+  std::string next(std::uint64_t now_ms);
+
+ private:
+  std::mutex mu_;
+  std::mt19937_64 rng_{std::random_device{}()};
+  std::uint64_t last_ms_ = 0;
+  std::uint32_t seq_ = 0;
+};
+
+// The millisecond timestamp encoded in an id from new_id(), or 0 if malformed.
+std::int64_t id_time_ms(const std::string& id);
+
+}  // namespace db
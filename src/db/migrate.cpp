@@ -1,14 +1,12 @@
 #include "db/migrate.hpp"
 
-#include <algorithm>
 #include <chrono>
-#include <filesystem>
-#include <fstream>
+#include <iterator>
 #include <set>
-#include <sstream>
 #include <stdexcept>
 #include <string>
-#include <vector>
+
+#include "db/embedded_migrations.hpp"
 
 namespace db {
 
@@ -22,28 +20,14 @@ static void exec(sqlite3* db, const std::string& sql) {
   }
 }
 
-static std::string read_file(const std::filesystem::path& p) {
-  std::ifstream in(p, std::ios::in | std::ios::binary);
-  if (!in) throw std::runtime_error("failed to read migration file: " + p.string());
-  std::ostringstream ss;
-  ss << in.rdbuf();
-  return ss.str();
-}
-
+// Versions recorded by builds that tracked migrations only in
+// schema_migrations. Empty if the table doesn't exist.
 static std::set<std::string> load_applied(sqlite3* db) {
-  exec(db,
-       "CREATE TABLE IF NOT EXISTS schema_migrations ("
-       "  version TEXT PRIMARY KEY,"
-       "  applied_at INTEGER NOT NULL"
-       ");");
-
   std::set<std::string> out;
 
   sqlite3_stmt* stmt = nullptr;
   const char* sql = "SELECT version FROM schema_migrations;";
-  if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-    throw std::runtime_error(sqlite3_errmsg(db));
-  }
+  if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) return out;
 
   while (true) {
     int rc = sqlite3_step(stmt);
@@ -80,38 +64,52 @@ static void mark_applied(sqlite3* db, const std::string& version) {
   if (rc != SQLITE_DONE) throw std::runtime_error(sqlite3_errmsg(db));
 }
 
-static std::string version_from_filename(const std::filesystem::path& p) {
-  // e.g. 0001_initial.up.sql -> 0001_initial
-  auto name = p.filename().string();
-  auto pos = name.find(".up.sql");
-  if (pos == std::string::npos) return "";
-  return name.substr(0, pos);
+static int user_version(sqlite3* db) {
+  sqlite3_stmt* stmt = nullptr;
+  if (sqlite3_prepare_v2(db, "PRAGMA user_version;", -1, &stmt, nullptr) != SQLITE_OK) {
+    throw std::runtime_error(sqlite3_errmsg(db));
+  }
+  int v = sqlite3_step(stmt) == SQLITE_ROW ? sqlite3_column_int(stmt, 0) : 0;
+  sqlite3_finalize(stmt);
+  return v;
 }
 
-void apply_migrations(sqlite3* db, const std::string& migrations_dir) {
-  namespace fs = std::filesystem;
+static void set_user_version(sqlite3* db, int v) {
+  exec(db, "PRAGMA user_version = " + std::to_string(v) + ";");
+}
 
-  auto applied = load_applied(db);
+void apply_migrations(sqlite3* db) {
+  const auto& all = embedded::k_migrations;
+  const int latest = std::size(all) ? all[std::size(all) - 1].number : 0;
 
-  std::vector<fs::path> ups;
-  for (auto const& entry : fs::directory_iterator(fs::path(migrations_dir))) {
-    if (!entry.is_regular_file()) continue;
-    auto p = entry.path();
-    if (p.filename().string().ends_with(".up.sql")) ups.push_back(p);
+  int current = user_version(db);
+  if (current == latest) return;
+  if (current > latest) {
+    throw std::runtime_error("database schema version " + std::to_string(current) +
+                             " is newer than this build supports (" + std::to_string(latest) + ")");
   }
 
-  std::sort(ups.begin(), ups.end());
+  // Databases from before user_version was used: adopt whatever prefix of
+  // the migrations schema_migrations says already ran.
+  if (current == 0) {
+    auto applied = load_applied(db);
+    for (const auto& m : all) {
+      if (!applied.contains(std::string(m.version))) break;
+      current = m.number;
+    }
+    if (current > 0) set_user_version(db, current);
+  }
 
-  for (auto const& file : ups) {
-    auto ver = version_from_filename(file);
-    if (ver.empty()) continue;
-    if (applied.contains(ver)) continue;
+  for (const auto& m : all) {
+    if (m.number <= current) continue;
 
-    // Apply each migration in a transaction.
+    // Each migration and its version bump commit together. schema_migrations
+    // is still filled in as a history (and for older builds).
     exec(db, "BEGIN;");
     try {
-      exec(db, read_file(file));
-      mark_applied(db, ver);
+      exec(db, std::string(m.up_sql));
+      mark_applied(db, std::string(m.version));
+      set_user_version(db, m.number);
       exec(db, "COMMIT;");
     } catch (...) {
       exec(db, "ROLLBACK;");
@@ -2,12 +2,11 @@
 
 #include <sqlite3.h>
 
-#include <string>
-
 namespace db {
 
-// Applies all *.up.sql migrations in the given directory.
-// Uses a schema_migrations table to ensure each version runs once.
-void apply_migrations(sqlite3* db, const std::string& migrations_dir);
+// Applies the migrations embedded at build time (migrations/*.up.sql) that
+// the database hasn't run yet. PRAGMA user_version holds the number of the
+// last one applied, so an up-to-date database costs a single pragma read.
+void apply_migrations(sqlite3* db);
 
 }  // namespace db
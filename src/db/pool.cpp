@@ -0,0 +1,54 @@
+#include "db/pool.hpp"
+
+namespace db {
+
+Reader::Reader(Reader&& other) noexcept
+    : pool_(other.pool_), db_(other.db_), lk_(std::move(other.lk_)) {
+  other.pool_ = nullptr;
+  other.db_ = nullptr;
+}
+
+Reader::~Reader() {
+  if (pool_) pool_->release(db_);
+}
+
+Pool::Pool(const std::string& data_dir, std::size_t readers, const Tuning& tuning)
+    : data_dir_(data_dir), writer_(connect(data_dir, tuning)) {
+  readers_.reserve(readers);
+  for (std::size_t i = 0; i < readers; i++) {
+    readers_.push_back(connect_reader(data_dir, tuning));
+  }
+  for (auto& r : readers_) idle_.push_back(&r);
+  if (readers > 0) executor_reader_.emplace(connect_reader(data_dir, tuning));
+}
+
+Pool::Pool(Db writer) : writer_(std::move(writer)) {}
+
+Writer Pool::writer() {
+  return Writer(&writer_, std::unique_lock<std::recursive_mutex>(writer_mu_));
+}
+
+Reader Pool::reader() {
+  if (readers_.empty()) {
+    return Reader(&writer_, std::unique_lock<std::recursive_mutex>(writer_mu_));
+  }
+  if (executor_reader_ && executor_.on_executor_thread()) {
+    return Reader(nullptr, &*executor_reader_);
+  }
+
+  std::unique_lock<std::mutex> lk(mu_);
+  cv_.wait(lk, [&] { return !idle_.empty(); });
+  Db* db = idle_.back();
+  idle_.pop_back();
+  return Reader(this, db);
+}
+
+void Pool::release(Db* db) {
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    idle_.push_back(db);
+  }
+  cv_.notify_one();
+}
+
+}  // namespace db
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "db/db.hpp"
+#include "db/executor.hpp"
+
+namespace db {
+
+class Pool;
+
+// Exclusive loan of a read connection; returned to the pool on destruction.
+class Reader {
+ public:
+  Reader(const Reader&) = delete;
+  Reader& operator=(const Reader&) = delete;
+  Reader(Reader&& other) noexcept;
+  Reader& operator=(Reader&&) = delete;
+  ~Reader();
+
+  Db& operator*() const { return *db_; }
+  Db* operator->() const { return db_; }
+
+ private:
+  friend class Pool;
+  Reader(Pool* pool, Db* db) : pool_(pool), db_(db) {}
+  // Single-connection pools lend the writer, under the writer lock.
+  Reader(Db* db, std::unique_lock<std::recursive_mutex> lk) : db_(db), lk_(std::move(lk)) {}
+
+  Pool* pool_ = nullptr;
+  Db* db_ = nullptr;
+  std::unique_lock<std::recursive_mutex> lk_;
+};
+
+// Exclusive use of the writer connection: holds the pool's writer lock until
+// destroyed, so statements and transactions from different threads never
+// interleave on it. The lock is re-entrant, so code holding a Writer can call
+// helpers that take one too.
+class Writer {
+ public:
+  Writer(Writer&&) noexcept = default;
+  Writer& operator=(Writer&&) = delete;
+
+  Db& operator*() const { return *db_; }
+  Db* operator->() const { return db_; }
+
+ private:
+  friend class Pool;
+  Writer(Db* db, std::unique_lock<std::recursive_mutex> lk) : db_(db), lk_(std::move(lk)) {}
+
+  Db* db_;
+  std::unique_lock<std::recursive_mutex> lk_;
+};
+
+// One shared writer connection plus N read-only connections to the same WAL
+// database, so history loads run in parallel with each other and with writes.
+class Pool {
+ public:
+  // Runs connect() for the writer (creating/migrating the schema), then opens
+  // `readers` read-only connections, all with the same tuning. With readers
+  // > 0 one more is opened and kept for the executor thread.
+  Pool(const std::string& data_dir, std::size_t readers, const Tuning& tuning = {});
+  // Single-connection pool: reader() hands out the writer itself.
+  explicit Pool(Db writer);
+
+  Pool(const Pool&) = delete;
+  Pool& operator=(const Pool&) = delete;
+
+  // Blocks until no other thread holds the writer.
+  Writer writer();
+
+  // Directory holding openvim.db; empty for a pool built from a bare Db.
+  const std::string& data_dir() const { return data_dir_; }
+
+  // Blocks until a read connection is free. On the executor thread, returns
+  // its own connection without waiting, so async reads never queue behind
+  // readers held by other threads.
+  Reader reader();
+
+  std::size_t reader_count() const { return readers_.size(); }
+
+  // Thread for the services' async_* calls. Stopped before the connections
+  // close; services drain it in their destructors.
+  Executor& executor() { return executor_; }
+
+ private:
+  friend class Reader;
+  void release(Db* db);
+
+  std::string data_dir_;
+  Db writer_;
+  std::recursive_mutex writer_mu_;
+  std::vector<Db> readers_;
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::vector<Db*> idle_;
+
+  // Only touched from executor_'s thread.
+  std::optional<Db> executor_reader_;
+  Executor executor_;
+};
+
+}  // namespace db
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace db {
+
+// Lowercase hex SHA-256 digest (64 chars), used to content-address blobs.
+std::string sha256_hex(std::string_view data);
+
+}  // namespace db
@@ -0,0 +1,58 @@
+#include "llm/context.hpp"
+
+#include <algorithm>
+#include <functional>
+
+#include "json.hpp"
+
+namespace llm {
+
+std::string message_json(message::Role role, std::string_view content) {
+  nlohmann::json j = nlohmann::json::object();
+  j["role"] = role == message::Role::User ? "user" : "assistant";
+  j["content"] = content;
+  return j.dump();
+}
+
+void PromptContext::append(const message::Message& m, std::string_view content) {
+  // Ids are time-ordered, so the common case is a push at the end; concurrent
+  // create() calls can deliver events out of order.
+  auto pos = std::lower_bound(entries_.begin(), entries_.end(), m.id,
+                              [](const Entry& e, const std::string& id) { return e.id < id; });
+  if (pos != entries_.end() && pos->id == m.id) return;
+
+  auto json = message_json(m.role, content);
+  Entry entry{m.id, serialized_.size(), json.size()};
+  if (pos == entries_.end()) {
+    if (!serialized_.empty()) {
+      serialized_ += ',';
+      entry.offset++;
+    }
+    serialized_ += json;
+    entries_.push_back(std::move(entry));
+  } else {
+    entry.offset = pos->offset;
+    serialized_.insert(entry.offset, json + ',');
+    for (auto later = pos; later != entries_.end(); ++later) later->offset += json.size() + 1;
+    entries_.insert(pos, std::move(entry));
+  }
+  if (m.role == message::Role::User) user_hashes_.emplace(std::hash<std::string_view>{}(content), m.id);
+}
+
+bool PromptContext::has_user_message(std::string_view content) const {
+  auto [first, last] = user_hashes_.equal_range(std::hash<std::string_view>{}(content));
+  if (first == last) return false;
+
+  auto json = message_json(message::Role::User, content);
+  for (auto it = first; it != last; ++it) {
+    auto e = std::lower_bound(entries_.begin(), entries_.end(), it->second,
+                              [](const Entry& e, const std::string& id) { return e.id < id; });
+    if (e != entries_.end() && e->id == it->second &&
+        std::string_view(serialized_).substr(e->offset, e->length) == json) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace llm
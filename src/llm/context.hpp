@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "message/message.hpp"
+
+namespace llm {
+
+// One chat message as a serialized chat-completions object.
+std::string message_json(message::Role role, std::string_view content);
+
+// A session's history in the form a chat request sends it, kept serialized
+// and appended to as messages are created, so a turn costs the bytes added
+// since the last one rather than a rebuild of the whole conversation.
+class PromptContext {
+ public:
+  // m's full text is `content` (m.content may be a preview). Messages are
+  // kept in id order: one older than the newest is spliced into place, and
+  // one already present is ignored, so replaying an event the context was
+  // loaded with is harmless.
+  void append(const message::Message& m, std::string_view content);
+
+  // The history as comma-separated message objects, ready to go between the
+  // brackets of a "messages" array. Empty if there are no messages.
+  const std::string& serialized() const { return serialized_; }
+
+  // Whether a user message with exactly this text is in the history. Looks
+  // candidates up by hash and confirms them against the stored text, so it
+  // is O(len(content)) however long the history is.
+  bool has_user_message(std::string_view content) const;
+
+  std::size_t size() const { return entries_.size(); }
+  std::size_t bytes() const { return serialized_.size(); }
+
+ private:
+  // Where one message's object sits in serialized_, in id order.
+  struct Entry {
+    std::string id;
+    std::size_t offset = 0;
+    std::size_t length = 0;
+  };
+
+  std::string serialized_;
+  std::vector<Entry> entries_;
+  // Content hash of each user message -> its id.
+  std::unordered_multimap<std::size_t, std::string> user_hashes_;
+};
+
+}  // namespace llm
@@ -0,0 +1,111 @@
+#include "llm/http_pool.hpp"
+
+#include <optional>
+#include <utility>
+
+#include "httplib.h"
+
+namespace llm {
+
+Endpoint parse_base_url(const std::string& url) {
+  auto scheme = url.find("://");
+  auto host_start = scheme == std::string::npos ? 0 : scheme + 3;
+  auto slash = url.find('/', host_start);
+  if (slash == std::string::npos) return {url, ""};
+
+  Endpoint ep{url.substr(0, slash), url.substr(slash)};
+  while (!ep.prefix.empty() && ep.prefix.back() == '/') ep.prefix.pop_back();
+  return ep;
+}
+
+struct HttpPool::Host {
+  std::string origin;
+  std::vector<std::unique_ptr<httplib::Client>> idle;
+  std::size_t open = 0;  // idle plus leased
+};
+
+HttpPool::Lease::Lease(HttpPool* pool, Host* host, std::unique_ptr<httplib::Client> client)
+    : pool_(pool), host_(host), client_(std::move(client)) {}
+
+HttpPool::Lease::Lease(Lease&& other) noexcept
+    : pool_(other.pool_),
+      host_(other.host_),
+      client_(std::move(other.client_)),
+      discard_(other.discard_) {
+  other.pool_ = nullptr;
+}
+
+HttpPool::Lease::~Lease() {
+  if (pool_) pool_->release(host_, std::move(client_), discard_);
+}
+
+HttpPool::HttpPool(Options opts) : opts_(opts) {
+  if (opts_.max_per_origin == 0) opts_.max_per_origin = 1;
+}
+
+HttpPool::~HttpPool() = default;
+
+HttpPool::Lease HttpPool::acquire(const std::string& origin, const tools::CancelToken* cancel) {
+  // As in Scheduler::acquire_call(): declared before lk so it is unregistered
+  // after mu_ is released.
+  std::optional<tools::CancelToken::Registration> wake;
+  if (cancel) {
+    wake.emplace(cancel->on_cancel([this] {
+      { std::lock_guard<std::mutex> lk(mu_); }
+      cv_.notify_all();
+    }));
+  }
+
+  std::unique_lock<std::mutex> lk(mu_);
+  auto& slot = hosts_[origin];
+  if (!slot) {
+    slot = std::make_unique<Host>();
+    slot->origin = origin;
+  }
+  Host* host = slot.get();
+
+  cv_.wait(lk, [&] {
+    return !host->idle.empty() || host->open < opts_.max_per_origin ||
+           (cancel && cancel->cancelled());
+  });
+  if (cancel) cancel->throw_if_cancelled();
+
+  // Most recently returned first: it is the least likely to have been closed
+  // by the server's idle timeout.
+  if (!host->idle.empty()) {
+    auto client = std::move(host->idle.back());
+    host->idle.pop_back();
+    return Lease(this, host, std::move(client));
+  }
+
+  host->open++;
+  opened_++;
+  lk.unlock();
+
+  // httplib reconnects on its own if the server closed a kept-alive socket,
+  // so a client only needs setting up once.
+  auto client = std::make_unique<httplib::Client>(origin);
+  client->set_keep_alive(true);
+  client->set_connection_timeout(opts_.connect_timeout);
+  client->set_read_timeout(opts_.read_timeout);
+  return Lease(this, host, std::move(client));
+}
+
+void HttpPool::release(Host* host, std::unique_ptr<httplib::Client> client, bool discard) {
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (discard || !client) {
+      host->open--;
+    } else {
+      host->idle.push_back(std::move(client));
+    }
+  }
+  cv_.notify_all();
+}
+
+std::size_t HttpPool::connections_opened() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return opened_;
+}
+
+}  // namespace llm
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "tools/cancel.hpp"
+
+namespace httplib {
+class Client;
+}
+
+namespace llm {
+
+// A base URL such as "https://api.openai.com/v1" split into the part a
+// connection is opened to and the path prefix every request goes under.
+struct Endpoint {
+  std::string origin;  // "https://api.openai.com"
+  std::string prefix;  // "/v1", or "" if the URL has no path
+};
+
+Endpoint parse_base_url(const std::string& url);
+
+// Keep-alive httplib clients shared by every worker thread, grouped by
+// origin. A client owns one socket (and its TLS session) and is used by one
+// request at a time, so a warm one is leased out per request and returned
+// after; the handshakes are paid once per connection rather than once per
+// round trip. At most max_per_origin connections are open to an origin;
+// acquire() waits for one to come back once they are all leased.
+class HttpPool {
+  struct Host;
+
+ public:
+  struct Options {
+    std::size_t max_per_origin = 4;
+    std::chrono::seconds connect_timeout{10};
+    // Streamed completions can go quiet for a while between tokens.
+    std::chrono::seconds read_timeout{300};
+  };
+
+  class Lease {
+   public:
+    Lease(Lease&& other) noexcept;
+    Lease& operator=(Lease&&) = delete;
+    ~Lease();
+
+    httplib::Client& operator*() const { return *client_; }
+    httplib::Client* operator->() const { return client_.get(); }
+
+    // Closes the connection instead of returning it, e.g. after a transfer
+    // was aborted midway and the socket is in an unknown state.
+    void discard() { discard_ = true; }
+
+   private:
+    friend class HttpPool;
+    Lease(HttpPool* pool, Host* host, std::unique_ptr<httplib::Client> client);
+
+    HttpPool* pool_;
+    Host* host_;
+    std::unique_ptr<httplib::Client> client_;
+    bool discard_ = false;
+  };
+
+  explicit HttpPool(Options opts);
+  HttpPool() : HttpPool(Options{}) {}
+  ~HttpPool();
+
+  HttpPool(const HttpPool&) = delete;
+  HttpPool& operator=(const HttpPool&) = delete;
+
+  // Waits while every connection to origin is leased. Throws
+  // tools::Cancelled if `cancel` is cancelled first (or already was).
+  Lease acquire(const std::string& origin, const tools::CancelToken* cancel = nullptr);
+
+  // Connections opened so far, for logging.
+  std::size_t connections_opened() const;
+
+ private:
+  void release(Host* host, std::unique_ptr<httplib::Client> client, bool discard);
+
+  Options opts_;
+  mutable std::mutex mu_;
+  std::condition_variable cv_;
+  std::map<std::string, std::unique_ptr<Host>> hosts_;
+  std::size_t opened_ = 0;
+};
+
+}  // namespace llm
@@ -1,6 +1,9 @@
 #include "llm/llm.hpp"
 
+#include <algorithm>
 #include <chrono>
+#include <exception>
+#include <optional>
 #include <sstream>
 #include <iostream>
 #include <thread>
@@ -20,10 +23,31 @@
 #include "tools/write_tool.hpp"
 #include "tools/mcp_tool.hpp"
 
+#include "llm/sse.hpp"
+
 namespace llm {
 
+struct Service::Turn {
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  // Set when the first token (or the whole non-streamed reply) arrives.
+  std::optional<std::chrono::steady_clock::time_point> first_token;
+  std::size_t deltas = 0;
+  std::shared_ptr<tools::CancelToken> cancel;
+};
+
+// Message events queued between turns before the oldest are dropped (and the
+// contexts rebuilt instead).
+static constexpr std::size_t kMaxMessageEvents = 4096;
+
 Service::Service(logging::Logger& log, message::Service& messages, const config::Config& config) 
-    : log_(log), messages_(messages), config_(config) {
+    : log_(log),
+      messages_(messages),
+      config_(config),
+      endpoint_(parse_base_url(config.llm_base_url)),
+      http_(HttpPool::Options{(std::size_t)config.llm_connections}),
+      message_events_(messages.subscribe_shared(pubsub::SubscribeOptions{
+          .high_water = kMaxMessageEvents, .overflow = pubsub::Overflow::DropOldest})),
+      scheduler_(Scheduler::Options{(std::size_t)config.llm_workers, (std::size_t)config.llm_max_in_flight}) {
   // Initialize tools
   tools_.push_back(std::make_unique<tools::BashTool>(working_dir_));
   tools_.push_back(std::make_unique<tools::AgentTool>(working_dir_));
@@ -44,92 +68,213 @@ Service::Service(logging::Logger& log, message::Service& messages, const config:
       log_.error("Failed to initialize MCP tool '" + mcp_server.name + "': " + e.what());
     }
   }
+  
+  // Build tools array for LLM API
+  tools_json_ = nlohmann::json::array();
+  for (const auto& tool : tools_) {
+    nlohmann::json tool_def = nlohmann::json::object();
+    tool_def["type"] = "function";
+    
+    nlohmann::json function_def = nlohmann::json::object();
+    function_def["name"] = tool->name();
+    function_def["description"] = tool->description();
+    
+    nlohmann::json parameters = nlohmann::json::object();
+    parameters["type"] = "object";
+    
+    nlohmann::json properties = nlohmann::json::object();
+    nlohmann::json args_prop = nlohmann::json::object();
+    args_prop["type"] = "array";
+    args_prop["items"] = nlohmann::json::object({{"type", "string"}});
+    args_prop["description"] = "Command line arguments to pass to the tool";
+    properties["args"] = args_prop;
+    
+    parameters["properties"] = properties;
+    nlohmann::json required = nlohmann::json::array();
+    required.push_back("args");
+    parameters["required"] = required;
+    
+    function_def["parameters"] = parameters;
+    tool_def["function"] = function_def;
+    
+    tools_json_.push_back(tool_def);
+  }
 }
 
-void Service::send_request(const std::string& session_id, const std::string& content) {
-  broker_.publish(pubsub::EventType::Created, AgentEvent{AgentEventType::Request, session_id, content});
-  std::thread(&Service::worker, this, session_id, content).detach();
+// Contexts kept in memory at once; the least recently used is dropped and
+// rebuilt from the database if its session comes back.
+static constexpr std::size_t kMaxContexts = 64;
+
+void Service::apply_message_events() {
+  std::vector<pubsub::SharedEvent<message::Message>> events;
+  message_events_->drain(SIZE_MAX, events);
+
+  // Some events were dropped, so any context may be missing messages.
+  auto dropped = message_events_->stats().dropped;
+  if (dropped != message_events_dropped_) {
+    message_events_dropped_ = dropped;
+    contexts_.clear();
+    for (auto& [id, loading] : loading_) loading.stale = true;
+    return;
+  }
+
+  for (const auto& ev : events) {
+    if (ev->type != pubsub::EventType::Created) continue;
+    const auto& m = ev->payload;
+    auto loading = loading_.find(m.session_id);
+    if (loading != loading_.end()) loading->second.created.push_back(m);
+    // Sessions without a context get theirs from the database, which already
+    // includes m, when next used.
+    auto it = contexts_.find(m.session_id);
+    if (it == contexts_.end()) continue;
+    // Created events carry the full content even when the row stores a preview.
+    it->second.context.append(m, m.content);
+  }
 }
 
-void Service::worker(std::string session_id, std::string content) {
-  using namespace std::chrono_literals;
-  std::this_thread::sleep_for(300ms);
+void Service::trim_contexts() {
+  if (contexts_.size() < kMaxContexts) return;
+  auto oldest = contexts_.begin();
+  for (auto c = contexts_.begin(); c != contexts_.end(); ++c) {
+    if (c->second.used < oldest->second.used) oldest = c;
+  }
+  contexts_.erase(oldest);
+}
 
-  try {
-    // Get conversation history for this session
-    auto conversation_messages = messages_.list(session_id);
-    
-    // Build messages array for LLM API
-    nlohmann::json messages_json = nlohmann::json::array();
-    
-    // Add system message
-    nlohmann::json system_msg = nlohmann::json::object();
-    system_msg["role"] = "system";
-    system_msg["content"] = "You are an AI assistant with access to various tools. Use the tools when appropriate to help the user. Be concise but helpful.";
-    messages_json.push_back(system_msg);
-    
-    // Add conversation history (excluding system messages)
-    for (const auto& msg : conversation_messages) {
-      nlohmann::json msg_json = nlohmann::json::object();
-      msg_json["role"] = (msg.role == message::Role::User) ? "user" : "assistant";
-      msg_json["content"] = msg.content;
-      messages_json.push_back(msg_json);
-    }
-    
-    // Add the new user message if not already in history
-    bool has_current_message = false;
-    for (const auto& msg : conversation_messages) {
-      if (msg.content == content && msg.role == message::Role::User) {
-        has_current_message = true;
-        break;
+std::string Service::prompt_history(const std::string& session_id, const std::string& content) {
+  std::unique_lock<std::mutex> lk(contexts_mu_);
+  apply_message_events();
+
+  PromptContext loaded;
+  const PromptContext* context = nullptr;
+  auto it = contexts_.find(session_id);
+  if (it == contexts_.end()) {
+    // Read the history without holding contexts_mu_, so turns in other
+    // sessions aren't stalled behind SQLite. Messages created meanwhile are
+    // collected in loading_ and applied on top.
+    loading_[session_id].loaders++;
+    lk.unlock();
+    std::exception_ptr error;
+    try {
+      for (const auto& msg : messages_.list(session_id)) {
+        loaded.append(msg, messages_.full_content(msg));
       }
+    } catch (...) {
+      error = std::current_exception();
     }
-    if (!has_current_message) {
-      nlohmann::json user_msg = nlohmann::json::object();
-      user_msg["role"] = "user";
-      user_msg["content"] = content;
-      messages_json.push_back(user_msg);
+    lk.lock();
+    apply_message_events();
+
+    auto loading = loading_.find(session_id);
+    bool stale = loading->second.stale;
+    for (const auto& m : loading->second.created) loaded.append(m, m.content);
+    if (--loading->second.loaders == 0) loading_.erase(loading);
+    if (error) std::rethrow_exception(error);
+
+    // Another turn may have loaded it first; theirs is as current as ours.
+    // A stale load still has everything created before this turn read the
+    // table, so it serves this turn but isn't kept.
+    it = contexts_.find(session_id);
+    if (it == contexts_.end() && !stale) {
+      trim_contexts();
+      it = contexts_.emplace(session_id, ContextEntry{std::move(loaded)}).first;
     }
+  }
+  if (it != contexts_.end()) {
+    it->second.used = ++context_clock_;
+    context = &it->second.context;
+  } else {
+    context = &loaded;
+  }
+
+  std::string history;
+  history.reserve(context->bytes() + content.size() + 64);
+  history = context->serialized();
+  // Add the new user message if not already in history
+  if (!context->has_user_message(content)) {
+    if (!history.empty()) history += ',';
+    history += message_json(message::Role::User, content);
+  }
+  return history;
+}
+
+Service::~Service() {
+  std::vector<std::shared_ptr<tools::CancelToken>> tokens;
+  {
+    std::lock_guard<std::mutex> lk(active_mu_);
+    for (auto& [id, active] : active_) tokens.push_back(std::move(active.cancel));
+    active_.clear();
+  }
+  for (auto& cancel : tokens) cancel->cancel();
+  // scheduler_ is destroyed next and joins the workers.
+}
+
+void Service::send_request(const std::string& session_id, const std::string& content) {
+  broker_.publish(pubsub::EventType::Created, AgentEvent{AgentEventType::Request, session_id, content});
+
+  std::shared_ptr<tools::CancelToken> cancel;
+  {
+    std::lock_guard<std::mutex> lk(active_mu_);
+    auto& active = active_[session_id];
+    if (!active.cancel) active.cancel = std::make_shared<tools::CancelToken>();
+    active.pending++;
+    cancel = active.cancel;
+  }
+  scheduler_.submit(session_id, [this, session_id, content, cancel] {
+    worker(session_id, content, cancel);
+    finish_request(session_id, cancel);
+  });
+}
+
+bool Service::cancel(const std::string& session_id) {
+  std::shared_ptr<tools::CancelToken> cancel;
+  {
+    std::lock_guard<std::mutex> lk(active_mu_);
+    auto it = active_.find(session_id);
+    if (it == active_.end()) return false;
+    cancel = std::move(it->second.cancel);
+    active_.erase(it);
+  }
+  // Outside the lock: callbacks close sockets and kill processes.
+  cancel->cancel();
+  log_.info("Cancelled LLM turns for session " + session_id);
+  broker_.publish(pubsub::EventType::Updated, AgentEvent{AgentEventType::Cancelled, session_id, ""});
+  return true;
+}
+
+void Service::finish_request(const std::string& session_id, const std::shared_ptr<tools::CancelToken>& cancel) {
+  std::lock_guard<std::mutex> lk(active_mu_);
+  auto it = active_.find(session_id);
+  // After a cancel the entry is gone or belongs to newer requests.
+  if (it == active_.end() || it->second.cancel != cancel) return;
+  if (--it->second.pending == 0) active_.erase(it);
+}
+
+void Service::worker(std::string session_id, std::string content, std::shared_ptr<tools::CancelToken> cancel) {
+  // Queued behind a turn that was cancelled.
+  if (cancel->cancelled()) return;
+
+  Turn turn;
+  turn.cancel = std::move(cancel);
+  try {
+    std::string history = prompt_history(session_id, content);
     
-    // Build tools array for LLM API
-    nlohmann::json tools_json = nlohmann::json::array();
-    for (const auto& tool : tools_) {
-      nlohmann::json tool_def = nlohmann::json::object();
-      tool_def["type"] = "function";
-      
-      nlohmann::json function_def = nlohmann::json::object();
-      function_def["name"] = tool->name();
-      function_def["description"] = tool->description();
-      
-      nlohmann::json parameters = nlohmann::json::object();
-      parameters["type"] = "object";
-      
-      nlohmann::json properties = nlohmann::json::object();
-      nlohmann::json args_prop = nlohmann::json::object();
-      args_prop["type"] = "array";
-      args_prop["items"] = nlohmann::json::object({{"type", "string"}});
-      args_prop["description"] = "Command line arguments to pass to the tool";
-      properties["args"] = args_prop;
-      
-      parameters["properties"] = properties;
-      nlohmann::json required = nlohmann::json::array();
-      required.push_back("args");
-      parameters["required"] = required;
-      
-      function_def["parameters"] = parameters;
-      tool_def["function"] = function_def;
-      
-      tools_json.push_back(tool_def);
-    }
+    // Assistant tool calls and tool results added during this turn
+    nlohmann::json turn_messages = nlohmann::json::array();
     
     // Make LLM API call
-    std::string response = call_llm_api(session_id, messages_json, tools_json);
+    std::string response = call_llm_api(session_id, history, turn_messages, tools_json_, turn);
     
     // Create assistant message
     messages_.create_assistant(session_id, response);
+    record_turn(turn, true);
     broker_.publish(pubsub::EventType::Created, AgentEvent{AgentEventType::Response, session_id, response});
     
+  } catch (const tools::Cancelled&) {
+    std::lock_guard<std::mutex> lk(metrics_mu_);
+    metrics_.cancelled++;
   } catch (const std::exception& e) {
+    record_turn(turn, false);
     log_.error(std::string("LLM error: ") + e.what());
     std::string error_msg = "Sorry, I encountered an error: " + std::string(e.what());
     messages_.create_assistant(session_id, error_msg);
@@ -138,10 +283,26 @@ void Service::worker(std::string session_id, std::string content) {
   }
 }
 
-std::shared_ptr<pubsub::Channel<pubsub::Event<AgentEvent>>> Service::subscribe() {
+pubsub::EventSubscription<AgentEvent> Service::subscribe() {
   return broker_.subscribe();
 }
 
+pubsub::SharedSubscription<AgentEvent> Service::subscribe_shared() {
+  return broker_.subscribe_shared();
+}
+
+static const std::string& session_of(const AgentEvent& ev) { return ev.session_id; }
+
+pubsub::EventSubscription<AgentEvent> Service::subscribe(
+    const std::string& session_id) {
+  return broker_.subscribe(pubsub::Filter<AgentEvent>{&session_of, session_id});
+}
+
+pubsub::SharedSubscription<AgentEvent> Service::subscribe_shared(
+    const std::string& session_id) {
+  return broker_.subscribe_shared(pubsub::Filter<AgentEvent>{&session_of, session_id});
+}
+
 std::string Service::generate_title(const std::string& content) {
   // Stub: Generate a simple title based on content.
   // In a real implementation, send to LLM with a prompt like:
@@ -153,22 +314,29 @@ std::string Service::generate_title(const std::string& content) {
   }
 }
 
-std::string Service::call_llm_api(const std::string& session_id, nlohmann::json& messages, const nlohmann::json& tools) {
+static httplib::Headers api_headers(const config::Config& config) {
+  return {
+    {"Authorization", "Bearer " + config.llm_api_key},
+    {"Content-Type", "application/json"}
+  };
+}
+
+static const std::string& system_message() {
+  static const std::string json = nlohmann::json{
+      {"role", "system"},
+      {"content", "You are an AI assistant with access to various tools. Use the tools when appropriate to help the user. Be concise but helpful."}
+  }.dump();
+  return json;
+}
+
+std::string Service::call_llm_api(const std::string& session_id, const std::string& history, nlohmann::json& messages,
+                                  const nlohmann::json& tools, Turn& turn) {
   if (config_.llm_api_key.empty()) {
     throw std::runtime_error("LLM API key not configured. Set OPENAI_API_KEY environment variable or use --llm-api-key flag.");
   }
   
-  // Create HTTP client
-  httplib::Client cli(config_.llm_base_url.c_str());
-  
-  // Build request headers
-  httplib::Headers headers = {
-    {"Authorization", "Bearer " + config_.llm_api_key},
-    {"Content-Type", "application/json"}
-  };
   nlohmann::json payload = {
     {"model", config_.llm_model},
-    {"messages", messages},
     {"max_tokens", config_.llm_max_tokens},
     {"temperature", config_.llm_temperature}
   };
@@ -177,9 +345,54 @@ std::string Service::call_llm_api(const std::string& session_id, nlohmann::json&
     payload["tools"] = tools;
     payload["tool_choice"] = "auto";
   }
+  if (config_.llm_stream) {
+    payload["stream"] = true;
+  }
+  
+  // The history is already serialized; splice it into the body as the
+  // "messages" array rather than parsing it back into the payload.
+  std::string body = payload.dump();
+  body.pop_back();  // '}'
+  body.reserve(body.size() + system_message().size() + history.size() + 64);
+  body += ",\"messages\":[";
+  body += system_message();
+  if (!history.empty()) {
+    body += ',';
+    body += history;
+  }
+  for (const auto& m : messages) {
+    body += ',';
+    body += m.dump();
+  }
+  body += "]}";
+  
+  nlohmann::json message;
+  if (config_.llm_stream) {
+    message = post_streaming(session_id, body, turn);
+  } else {
+    message = post_completion(body, turn);
+    if (!turn.first_token) turn.first_token = std::chrono::steady_clock::now();
+  }
+  
+  std::string content = message.value("content", "");
+  
+  // Handle tool calls
+  if (message.contains("tool_calls") && !message["tool_calls"].empty()) {
+    return handle_tool_calls(session_id, history, message["tool_calls"], messages, turn);
+  }
+  
+  return content;
+}
+
+nlohmann::json Service::post_completion(const std::string& body, Turn& turn) {
+  auto permit = scheduler_.acquire_call(turn.cancel.get());
+  auto cli = http_.acquire(endpoint_.origin, turn.cancel.get());
+  auto abort = turn.cancel->on_cancel([&cli] { cli->stop(); });
   
   // Make request
-  auto res = cli.Post("/chat/completions", headers, payload.dump(), "application/json");
+  auto res = cli->Post(endpoint_.prefix + "/chat/completions", api_headers(config_), body, "application/json");
+  if (!res || turn.cancel->cancelled()) cli.discard();
+  turn.cancel->throw_if_cancelled();
   
   if (!res || res->status != 200) {
     std::string error_msg = "LLM API request failed";
@@ -204,18 +417,143 @@ std::string Service::call_llm_api(const std::string& session_id, nlohmann::json&
     throw std::runtime_error("Invalid LLM API response: missing message");
   }
   
-  auto& message = choice["message"];
-  std::string content = message.value("content", "");
+  return choice["message"];
+}
+
+// Streamed tool calls arrive as fragments keyed by index: the first carries
+// id and function name, later ones append to function.arguments.
+static void merge_tool_call_deltas(nlohmann::json& calls, const nlohmann::json& deltas) {
+  for (const auto& d : deltas) {
+    std::size_t index = d.value("index", (std::size_t)calls.size());
+    while (calls.size() <= index) {
+      calls.push_back({{"id", ""}, {"type", "function"}, {"function", {{"name", ""}, {"arguments", ""}}}});
+    }
+    auto& call = calls[index];
+    if (d.contains("id") && d["id"].is_string()) call["id"] = d["id"];
+    if (d.contains("type") && d["type"].is_string()) call["type"] = d["type"];
+    if (d.contains("function")) {
+      const auto& f = d["function"];
+      if (f.contains("name") && f["name"].is_string()) {
+        call["function"]["name"] = call["function"]["name"].get<std::string>() + f["name"].get<std::string>();
+      }
+      if (f.contains("arguments") && f["arguments"].is_string()) {
+        call["function"]["arguments"] =
+            call["function"]["arguments"].get<std::string>() + f["arguments"].get<std::string>();
+      }
+    }
+  }
+}
+
+nlohmann::json Service::post_streaming(const std::string& session_id, const std::string& body, Turn& turn) {
+  std::string content;
+  nlohmann::json tool_calls = nlohmann::json::array();
+  SseParser sse([&](const std::string&, const std::string& data) {
+    if (data == "[DONE]") return;
+    auto chunk = nlohmann::json::parse(data, nullptr, false);
+    if (chunk.is_discarded() || !chunk.contains("choices") || chunk["choices"].empty()) return;
+    const auto& choice = chunk["choices"][0];
+    if (!choice.contains("delta")) return;
+    const auto& delta = choice["delta"];
+    
+    // The first chunk usually carries only the role; time to first token
+    // counts from the first content or tool call fragment.
+    if (delta.contains("content") && delta["content"].is_string()) {
+      auto text = delta["content"].get<std::string>();
+      if (!text.empty()) {
+        if (!turn.first_token) turn.first_token = std::chrono::steady_clock::now();
+        content += text;
+        turn.deltas++;
+        broker_.publish(pubsub::EventType::Updated, AgentEvent{AgentEventType::Delta, session_id, std::move(text)});
+      }
+    }
+    if (delta.contains("tool_calls") && delta["tool_calls"].is_array() && !delta["tool_calls"].empty()) {
+      if (!turn.first_token) turn.first_token = std::chrono::steady_clock::now();
+      merge_tool_call_deltas(tool_calls, delta["tool_calls"]);
+    }
+  });
   
-  // Handle tool calls
-  if (message.contains("tool_calls") && !message["tool_calls"].empty()) {
-    return handle_tool_calls(session_id, message["tool_calls"], messages);
+  httplib::Request req;
+  req.method = "POST";
+  req.path = endpoint_.prefix + "/chat/completions";
+  req.headers = api_headers(config_);
+  req.headers.emplace("Accept", "text/event-stream");
+  req.body = body;
+  
+  int status = 0;
+  std::string error_body;
+  req.response_handler = [&](const httplib::Response& r) {
+    status = r.status;
+    return true;
+  };
+  req.content_receiver = [&](const char* data, size_t len, uint64_t, uint64_t) {
+    if (turn.cancel->cancelled()) return false;
+    if (status != 200) {
+      error_body.append(data, len);
+    } else {
+      sse.feed(std::string_view(data, len));
+    }
+    return true;
+  };
+  
+  auto permit = scheduler_.acquire_call(turn.cancel.get());
+  auto cli = http_.acquire(endpoint_.origin, turn.cancel.get());
+  // Returning false from the receiver only helps once bytes arrive; closing
+  // the socket also ends a wait for the first one.
+  auto abort = turn.cancel->on_cancel([&cli] { cli->stop(); });
+  auto res = cli->send(req);
+  if (!res || turn.cancel->cancelled()) cli.discard();
+  turn.cancel->throw_if_cancelled();
+  if (!res || status != 200) {
+    std::string error_msg = "LLM API request failed";
+    if (res) {
+      error_msg += " (status: " + std::to_string(status) + ")";
+      if (!error_body.empty()) {
+        error_msg += ": " + error_body;
+      }
+    }
+    throw std::runtime_error(error_msg);
   }
+  sse.finish();
   
-  return content;
+  nlohmann::json message = {{"role", "assistant"}, {"content", content}};
+  if (!tool_calls.empty()) message["tool_calls"] = tool_calls;
+  return message;
+}
+
+void Service::record_turn(const Turn& turn, bool ok) {
+  using std::chrono::duration_cast;
+  using std::chrono::milliseconds;
+  
+  auto now = std::chrono::steady_clock::now();
+  auto total = duration_cast<milliseconds>(now - turn.start);
+  auto ttft = duration_cast<milliseconds>(turn.first_token.value_or(now) - turn.start);
+  {
+    std::lock_guard<std::mutex> lk(metrics_mu_);
+    metrics_.turns++;
+    if (!ok) metrics_.errors++;
+    metrics_.last_ttft = ttft;
+    metrics_.max_ttft = std::max(metrics_.max_ttft, ttft);
+    metrics_.total_ttft += ttft;
+    metrics_.last_turn = total;
+  }
+  if (ok) {
+    log_.info("LLM turn: first token " + std::to_string(ttft.count()) + " ms, total " +
+              std::to_string(total.count()) + " ms, " + std::to_string(turn.deltas) + " deltas");
+  }
+}
+
+Metrics Service::metrics() const {
+  Metrics m;
+  {
+    std::lock_guard<std::mutex> lk(metrics_mu_);
+    m = metrics_;
+  }
+  m.scheduler = scheduler_.stats();
+  return m;
 }
 
-std::string Service::handle_tool_calls(const std::string& session_id, const nlohmann::json& tool_calls, nlohmann::json& messages) {
+std::string Service::handle_tool_calls(const std::string& session_id, const std::string& history,
+                                       const nlohmann::json& tool_calls, nlohmann::json& messages, Turn& turn) {
   // Add the assistant's message with tool calls to the conversation
   nlohmann::json assistant_message = nlohmann::json::object();
   assistant_message["role"] = "assistant";
@@ -251,7 +589,9 @@ std::string Service::handle_tool_calls(const std::string& session_id, const nloh
     }
     
     // Execute tool
-    tools::ToolResult result = tool->execute(args);
+    turn.cancel->throw_if_cancelled();
+    tools::ToolResult result = tool->execute(args, *turn.cancel);
+    turn.cancel->throw_if_cancelled();
     
     // Add tool result to messages
     nlohmann::json tool_message = nlohmann::json::object();
@@ -263,7 +603,7 @@ std::string Service::handle_tool_calls(const std::string& session_id, const nloh
   
   // Make follow-up LLM call with tool results
   nlohmann::json follow_up_tools = nlohmann::json::array(); // Empty tools for follow-up
-  return call_llm_api(session_id, messages, follow_up_tools);
+  return call_llm_api(session_id, history, messages, follow_up_tools, turn);
 }
 
 }  // namespace llm
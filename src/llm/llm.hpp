@@ -1,11 +1,18 @@
 #pragma once
 
+#include <chrono>
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
+#include "llm/context.hpp"
+#include "llm/http_pool.hpp"
+#include "llm/scheduler.hpp"
 #include "logging/logger.hpp"
 #include "message/message.hpp"
 #include "pubsub/broker.hpp"
@@ -18,8 +25,13 @@ namespace llm {
 
 enum class AgentEventType {
   Request,
+  // A streamed fragment of the assistant's reply; content holds only the new
+  // text. The complete reply follows as a Response.
+  Delta,
   Response,
   Error,
+  // The session's turns were cancelled; nothing more is persisted for them.
+  Cancelled,
 };
 
 struct AgentEvent {
@@ -28,14 +40,46 @@ struct AgentEvent {
   std::string content;
 };
 
+struct Metrics {
+  std::uint64_t turns = 0;
+  std::uint64_t errors = 0;
+  std::uint64_t cancelled = 0;
+  // Time to first token: from the start of a turn to its first streamed
+  // delta (or the whole reply when not streaming).
+  std::chrono::milliseconds last_ttft{0};
+  std::chrono::milliseconds max_ttft{0};
+  std::chrono::milliseconds total_ttft{0};
+  // Start of the turn to the persisted reply.
+  std::chrono::milliseconds last_turn{0};
+  SchedulerStats scheduler;
+};
+
 class Service {
  public:
   Service(logging::Logger& log, message::Service& messages, const config::Config& config);
+  // Cancels every turn in progress, so the workers can be joined without
+  // waiting out a stream or a tool.
+  ~Service();
+
+  Service(const Service&) = delete;
+  Service& operator=(const Service&) = delete;
 
-  // Fire-and-forget async request. Will create an assistant message and publish a Response event.
+  // Fire-and-forget async request. Queued behind any earlier request for the
+  // same session; will create an assistant message and publish a Response event.
   void send_request(const std::string& session_id, const std::string& content);
 
-  std::shared_ptr<pubsub::Channel<pubsub::Event<AgentEvent>>> subscribe();
+  // Stops the session's running turn and drops its queued ones: the HTTP
+  // transfer is aborted and running tool processes are killed. Returns false
+  // if the session had nothing in progress.
+  bool cancel(const std::string& session_id);
+
+  pubsub::EventSubscription<AgentEvent> subscribe();
+  pubsub::SharedSubscription<AgentEvent> subscribe_shared();
+
+  // Only receive events for the given session.
+  pubsub::EventSubscription<AgentEvent> subscribe(const std::string& session_id);
+  pubsub::SharedSubscription<AgentEvent> subscribe_shared(
+      const std::string& session_id);
 
   // Generate a title for the session based on the first message content.
   std::string generate_title(const std::string& content);
@@ -43,17 +87,81 @@ class Service {
   // Get available tools
   const std::vector<std::unique_ptr<tools::BaseTool>>& tools() const;
 
+  Metrics metrics() const;
+
  private:
-  void worker(std::string session_id, std::string content);
-  std::string call_llm_api(const std::string& session_id, nlohmann::json& messages, const nlohmann::json& tools);
-  std::string handle_tool_calls(const std::string& session_id, const nlohmann::json& tool_calls, nlohmann::json& messages);
+  struct Turn;
+
+  void worker(std::string session_id, std::string content, std::shared_ptr<tools::CancelToken> cancel);
+  void finish_request(const std::string& session_id, const std::shared_ptr<tools::CancelToken>& cancel);
+  // The session's history, serialized, with `content` appended as a user
+  // message unless it is already there.
+  std::string prompt_history(const std::string& session_id, const std::string& content);
+  // Brings loaded contexts up to date with messages created since the last
+  // call. Requires contexts_mu_.
+  void apply_message_events();
+  // Evicts the least recently used context if the cache is full. Requires
+  // contexts_mu_.
+  void trim_contexts();
+  // `messages` holds what this turn added after the history (tool calls and
+  // their results).
+  std::string call_llm_api(const std::string& session_id, const std::string& history, nlohmann::json& messages,
+                           const nlohmann::json& tools, Turn& turn);
+  std::string handle_tool_calls(const std::string& session_id, const std::string& history,
+                                const nlohmann::json& tool_calls, nlohmann::json& messages, Turn& turn);
+  // POSTs a chat completion request body and returns the assistant message
+  // object (content, tool_calls) once complete.
+  nlohmann::json post_completion(const std::string& body, Turn& turn);
+  nlohmann::json post_streaming(const std::string& session_id, const std::string& body, Turn& turn);
+  void record_turn(const Turn& turn, bool ok);
 
   logging::Logger& log_;
   message::Service& messages_;
   const config::Config& config_;
+  Endpoint endpoint_;
+  // Shared by every worker thread and by the follow-up request after tool
+  // calls, so a multi-step turn reuses one warm connection.
+  HttpPool http_;
   pubsub::Broker<AgentEvent> broker_;
   std::vector<std::unique_ptr<tools::BaseTool>> tools_;
   std::string working_dir_ = ".";
+  nlohmann::json tools_json_;
+
+  struct ContextEntry {
+    PromptContext context;
+    std::uint64_t used = 0;
+  };
+  // Sessions whose history is being read from the database outside
+  // contexts_mu_. Messages created meanwhile are kept here and applied to the
+  // loaded context; `stale` means some were dropped and it must be reloaded.
+  struct Loading {
+    std::size_t loaders = 0;
+    std::vector<message::Message> created;
+    bool stale = false;
+  };
+  // Bounded: if no turn drains it for a while the oldest events are dropped
+  // and every context is rebuilt from the database instead.
+  pubsub::SharedSubscription<message::Message> message_events_;
+  std::uint64_t message_events_dropped_ = 0;
+  std::mutex contexts_mu_;
+  std::unordered_map<std::string, ContextEntry> contexts_;
+  std::unordered_map<std::string, Loading> loading_;
+  std::uint64_t context_clock_ = 0;
+
+  // Requests sent and not yet finished, per session. They share one token
+  // until cancel() replaces it.
+  struct Active {
+    std::shared_ptr<tools::CancelToken> cancel;
+    std::size_t pending = 0;
+  };
+  std::mutex active_mu_;
+  std::unordered_map<std::string, Active> active_;
+
+  mutable std::mutex metrics_mu_;
+  Metrics metrics_;
+
+  // Last, so its workers are joined before anything they use is destroyed.
+  Scheduler scheduler_;
 };
 
 }  // namespace llm
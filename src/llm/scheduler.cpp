@@ -0,0 +1,109 @@
+#include "llm/scheduler.hpp"
+
+#include <algorithm>
+#include <optional>
+
+namespace llm {
+
+Scheduler::Scheduler(Options opts) : opts_(opts) {
+  if (opts_.workers == 0) opts_.workers = 1;
+  if (opts_.max_in_flight == 0) opts_.max_in_flight = 1;
+  threads_.reserve(opts_.workers);
+  for (std::size_t i = 0; i < opts_.workers; i++) {
+    threads_.emplace_back(&Scheduler::loop, this);
+  }
+}
+
+Scheduler::~Scheduler() {
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    stopping_ = true;
+  }
+  work_cv_.notify_all();
+  for (auto& t : threads_) t.join();
+}
+
+void Scheduler::submit(const std::string& session_id, std::function<void()> job) {
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    auto& q = sessions_[session_id];
+    q.jobs.push_back(std::move(job));
+    if (!q.running && q.jobs.size() == 1) ready_.push_back(session_id);
+    stats_.submitted++;
+    stats_.queued++;
+    stats_.max_queued = std::max(stats_.max_queued, stats_.queued);
+  }
+  work_cv_.notify_one();
+}
+
+void Scheduler::loop() {
+  std::unique_lock<std::mutex> lk(mu_);
+  while (true) {
+    work_cv_.wait(lk, [&] { return stopping_ || !ready_.empty(); });
+    if (stopping_) return;
+
+    auto session_id = std::move(ready_.front());
+    ready_.pop_front();
+    auto& q = sessions_[session_id];
+    auto job = std::move(q.jobs.front());
+    q.jobs.pop_front();
+    q.running = true;
+    stats_.queued--;
+    stats_.running++;
+    lk.unlock();
+
+    job();
+
+    lk.lock();
+    stats_.running--;
+    stats_.completed++;
+    // q is still valid: a session's entry is only erased by the worker
+    // running it.
+    q.running = false;
+    if (q.jobs.empty()) {
+      sessions_.erase(session_id);
+    } else {
+      ready_.push_back(std::move(session_id));
+      work_cv_.notify_one();
+    }
+  }
+}
+
+Scheduler::Permit Scheduler::acquire_call(const tools::CancelToken* cancel) {
+  // Wakes the wait below; taking mu_ first means the notify can't slip in
+  // between the waiter checking the predicate and going to sleep. Declared
+  // before lk so it is unregistered after mu_ is released.
+  std::optional<tools::CancelToken::Registration> wake;
+  if (cancel) {
+    wake.emplace(cancel->on_cancel([this] {
+      { std::lock_guard<std::mutex> lk(mu_); }
+      call_cv_.notify_all();
+    }));
+  }
+
+  std::unique_lock<std::mutex> lk(mu_);
+  stats_.waiting_calls++;
+  call_cv_.wait(lk, [&] {
+    return stats_.in_flight < opts_.max_in_flight || (cancel && cancel->cancelled());
+  });
+  stats_.waiting_calls--;
+  if (cancel) cancel->throw_if_cancelled();
+  stats_.in_flight++;
+  return Permit(this);
+}
+
+Scheduler::Permit::~Permit() {
+  if (!s_) return;
+  {
+    std::lock_guard<std::mutex> lk(s_->mu_);
+    s_->stats_.in_flight--;
+  }
+  s_->call_cv_.notify_one();
+}
+
+SchedulerStats Scheduler::stats() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return stats_;
+}
+
+}  // namespace llm
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "tools/cancel.hpp"
+
+namespace llm {
+
+struct SchedulerStats {
+  std::size_t queued = 0;       // jobs waiting for a worker
+  std::size_t max_queued = 0;   // high-water mark of queued
+  std::size_t running = 0;      // jobs on a worker right now
+  std::size_t in_flight = 0;    // API calls holding a permit
+  std::size_t waiting_calls = 0;  // API calls waiting for a permit
+  std::uint64_t submitted = 0;
+  std::uint64_t completed = 0;
+};
+
+// Runs LLM turns on a fixed set of worker threads. Jobs for one session run
+// one at a time in submission order, so a session's replies land in the order
+// its requests were sent; different sessions run in parallel. Separately,
+// at most max_in_flight API calls are outstanding at once across all workers
+// (a worker running tools between calls doesn't hold one).
+class Scheduler {
+ public:
+  struct Options {
+    std::size_t workers = 4;
+    std::size_t max_in_flight = 4;
+  };
+
+  // Held for the duration of one API call.
+  class Permit {
+   public:
+    Permit(Permit&& other) noexcept : s_(other.s_) { other.s_ = nullptr; }
+    Permit& operator=(Permit&&) = delete;
+    ~Permit();
+
+   private:
+    friend class Scheduler;
+    explicit Permit(Scheduler* s) : s_(s) {}
+    Scheduler* s_;
+  };
+
+  explicit Scheduler(Options opts);
+  // Lets running jobs finish and joins the workers. Jobs still queued are
+  // dropped.
+  ~Scheduler();
+
+  Scheduler(const Scheduler&) = delete;
+  Scheduler& operator=(const Scheduler&) = delete;
+
+  // job must not throw.
+  void submit(const std::string& session_id, std::function<void()> job);
+
+  // Blocks until fewer than max_in_flight calls are outstanding. Throws
+  // tools::Cancelled if `cancel` is cancelled first (or already was).
+  Permit acquire_call(const tools::CancelToken* cancel = nullptr);
+
+  SchedulerStats stats() const;
+
+ private:
+  void loop();
+
+  Options opts_;
+  mutable std::mutex mu_;
+  std::condition_variable work_cv_;
+  std::condition_variable call_cv_;
+  struct Queue {
+    std::deque<std::function<void()>> jobs;
+    bool running = false;
+  };
+  // Sessions with a job queued or running. A session is in ready_ when it
+  // has jobs queued and none running.
+  std::unordered_map<std::string, Queue> sessions_;
+  std::deque<std::string> ready_;
+  SchedulerStats stats_;
+  bool stopping_ = false;
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace llm
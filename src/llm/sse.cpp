@@ -0,0 +1,64 @@
+#include "llm/sse.hpp"
+
+namespace llm {
+
+SseParser::SseParser(Handler on_event) : on_event_(std::move(on_event)) {}
+
+void SseParser::feed(std::string_view chunk) {
+  pending_.append(chunk);
+
+  std::size_t start = 0;
+  while (true) {
+    auto nl = pending_.find('\n', start);
+    if (nl == std::string::npos) break;
+    std::string_view l(pending_.data() + start, nl - start);
+    if (!l.empty() && l.back() == '\r') l.remove_suffix(1);
+    line(l);
+    start = nl + 1;
+  }
+  pending_.erase(0, start);
+}
+
+void SseParser::finish() {
+  if (!pending_.empty()) {
+    std::string rest = std::move(pending_);
+    pending_.clear();
+    if (!rest.empty() && rest.back() == '\r') rest.pop_back();
+    line(rest);
+  }
+  dispatch();
+}
+
+void SseParser::line(std::string_view l) {
+  if (l.empty()) {
+    dispatch();
+    return;
+  }
+  if (l.front() == ':') return;  // comment / keep-alive
+
+  auto colon = l.find(':');
+  std::string_view field = l.substr(0, colon);
+  std::string_view value;
+  if (colon != std::string_view::npos) {
+    value = l.substr(colon + 1);
+    if (!value.empty() && value.front() == ' ') value.remove_prefix(1);
+  }
+
+  if (field == "data") {
+    if (has_data_) data_ += '\n';
+    data_.append(value);
+    has_data_ = true;
+  } else if (field == "event") {
+    event_.assign(value);
+  }
+  // id and retry only matter for reconnecting clients.
+}
+
+void SseParser::dispatch() {
+  if (has_data_) on_event_(event_.empty() ? "message" : event_, data_);
+  event_.clear();
+  data_.clear();
+  has_data_ = false;
+}
+
+}  // namespace llm
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace llm {
+
+// Incremental parser for text/event-stream bodies. Bytes may arrive in chunks
+// split anywhere, including inside a line. Lines end in "\n" or "\r\n".
+class SseParser {
+ public:
+  // Called once per event with its type ("message" if none was given) and
+  // its data lines joined by '\n'.
+  using Handler = std::function<void(const std::string& event, const std::string& data)>;
+
+  explicit SseParser(Handler on_event);
+
+  void feed(std::string_view chunk);
+
+  // Dispatches a final event the stream ended without a blank line after.
+  void finish();
+
+ private:
+  void line(std::string_view l);
+  void dispatch();
+
+  Handler on_event_;
+  std::string pending_;  // bytes after the last complete line
+  std::string event_;
+  std::string data_;
+  bool has_data_ = false;
+};
+
+}  // namespace llm
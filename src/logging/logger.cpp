@@ -23,8 +23,18 @@ std::vector<Message> Logger::list() const {
   return messages_;
 }
 
-std::shared_ptr<pubsub::Channel<pubsub::Event<Message>>> Logger::subscribe() {
-  return broker_.subscribe();
+pubsub::EventSubscription<Message> Logger::subscribe(
+    pubsub::SubscribeOptions opts) {
+  return broker_.subscribe(opts);
+}
+
+pubsub::SharedSubscription<Message> Logger::subscribe_shared(
+    pubsub::SubscribeOptions opts) {
+  return broker_.subscribe_shared(opts);
+}
+
+std::vector<pubsub::SubscriberStats> Logger::subscriber_stats() const {
+  return broker_.stats();
 }
 
 std::string level_to_string(Level lvl) {
@@ -33,7 +33,12 @@ class Logger {
 
   std::vector<Message> list() const;
 
-  std::shared_ptr<pubsub::Channel<pubsub::Event<Message>>> subscribe();
+  pubsub::EventSubscription<Message> subscribe(pubsub::SubscribeOptions opts = {});
+  pubsub::SharedSubscription<Message> subscribe_shared(
+      pubsub::SubscribeOptions opts = {});
+
+  // Queue depth and drop counts of every live subscriber.
+  std::vector<pubsub::SubscriberStats> subscriber_stats() const;
 
  private:
   void log(Level lvl, std::string msg);
@@ -1,10 +1,12 @@
 #include "config.hpp"
-#include "db/db.hpp"
+#include "db/checkpoint.hpp"
+#include "db/pool.hpp"
 #include "llm/llm.hpp"
 #include "logging/logger.hpp"
 #include "message/message.hpp"
 #include "permission/permission.hpp"
 #include "session/session.hpp"
+#include "transfer/transfer.hpp"
 
 #include <QQmlApplicationEngine>
 #include <QQmlContext>
@@ -13,10 +15,53 @@
 #include <QStandardPaths>
 #include <atomic>
 #include <chrono>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <string_view>
 #include <thread>
 
+// `openvim export|import [file]`: runs headless, without Qt or the services.
+static int run_transfer(const config::Config& cfg) {
+  std::ios::sync_with_stdio(false);
+  try {
+    db::Pool pool(cfg.data_dir, 0, *db::tuning_profile(cfg.storage_profile));
+    auto start = std::chrono::steady_clock::now();
+
+    transfer::Stats stats;
+    if (cfg.mode == "export") {
+      std::ofstream file;
+      if (!cfg.transfer_path.empty()) {
+        file.open(cfg.transfer_path, std::ios::binary | std::ios::trunc);
+        if (!file) throw std::runtime_error("cannot open " + cfg.transfer_path);
+      }
+      stats = transfer::export_jsonl(pool, cfg.transfer_path.empty() ? std::cout : file);
+    } else {
+      std::ifstream file;
+      if (!cfg.transfer_path.empty()) {
+        file.open(cfg.transfer_path, std::ios::binary);
+        if (!file) throw std::runtime_error("cannot open " + cfg.transfer_path);
+      }
+      stats = transfer::import_jsonl(pool, cfg.transfer_path.empty() ? std::cin : file);
+    }
+
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                  std::chrono::steady_clock::now() - start)
+                  .count();
+    std::cerr << (cfg.mode == "export" ? "Exported " : "Imported ") << stats.sessions
+              << " sessions, " << stats.messages << " messages in " << ms << " ms" << std::endl;
+    return 0;
+  } catch (const std::exception& e) {
+    std::cerr << cfg.mode << " failed: " << e.what() << std::endl;
+    return 1;
+  }
+}
+
 int main(int argc, char** argv) {
+  if (argc > 1 && (std::string_view(argv[1]) == "export" || std::string_view(argv[1]) == "import")) {
+    return run_transfer(config::parse_args_or_exit(argc, argv));
+  }
+
   QGuiApplication app(argc, argv);
 
   // Set application properties
@@ -37,9 +82,10 @@ int main(int argc, char** argv) {
     std::cout << "Logger created" << std::endl;
 
     std::cout << "Connecting to database..." << std::endl;
-    db::Db db;
+    std::unique_ptr<db::Pool> db;
     try {
-      db = db::connect(cfg.data_dir);
+      db = std::make_unique<db::Pool>(cfg.data_dir, (std::size_t)cfg.db_readers,
+                                      *db::tuning_profile(cfg.storage_profile));
       log.info("DB ready at data dir: " + cfg.data_dir);
       std::cout << "DB connected successfully" << std::endl;
     } catch (const std::exception& e) {
@@ -48,17 +94,32 @@ int main(int argc, char** argv) {
       return 1;
     }
 
+    db::CheckpointPolicy checkpoint_policy;
+    checkpoint_policy.truncate_bytes = (std::size_t)cfg.wal_truncate_mb * 1024 * 1024;
+    db::Checkpointer checkpointer(*db, checkpoint_policy, log);
+    log.info("Storage profile: " + cfg.storage_profile);
+
     std::cout << "Creating services..." << std::endl;
-    session::Service sessions(db);
-    message::Service messages(db);
+    session::Service sessions(*db);
+    message::Service messages(*db, message::Options{.write_behind = cfg.write_behind, .log = &log});
     llm::Service llm(log, messages, cfg);
     std::cout << "Services created successfully" << std::endl;
 
+    if (cfg.archive_after_days > 0) {
+      try {
+        auto moved = sessions.archive_idle(std::chrono::hours(24 * cfg.archive_after_days));
+        for (const auto& id : moved) messages.evict(id);
+        if (!moved.empty()) log.info("Archived " + std::to_string(moved.size()) + " idle sessions");
+      } catch (const std::exception& e) {
+        log.warn(std::string("Session archiving failed: ") + e.what());
+      }
+    }
+
     // Create an initial session if none exist
     std::cout << "Checking for existing sessions..." << std::endl;
     std::string active_session_id;
     try {
-      auto existing = sessions.list();
+      auto existing = sessions.list_recent(1);
       if (existing.empty()) {
         std::cout << "No existing sessions, creating welcome session..." << std::endl;
         auto s = sessions.create("Welcome session");
@@ -120,6 +181,22 @@ int main(int argc, char** argv) {
 
     int result = app.exec();
     std::cout << "Application exited with code: " << result << std::endl;
+
+    try {
+      messages.flush();
+    } catch (const std::exception& e) {
+      log.error(e.what());
+    }
+
+    auto cache = messages.cache_stats();
+    log.debug("Message cache: " + std::to_string(cache.hits) + " hits, " +
+              std::to_string(cache.misses) + " misses, " + std::to_string(cache.evictions) +
+              " evictions, " + std::to_string(cache.bytes) + " bytes in " +
+              std::to_string(cache.sessions) + " sessions");
+    auto turns = llm.metrics();
+    log.debug("LLM scheduler: " + std::to_string(turns.scheduler.completed) + "/" +
+              std::to_string(turns.scheduler.submitted) + " turns completed, queue high-water " +
+              std::to_string(turns.scheduler.max_queued));
     return result;
 
   } catch (const std::exception& e) {
@@ -1,22 +1,21 @@
 #include "message/message.hpp"
 
+#include <algorithm>
+#include <cctype>
 #include <chrono>
-#include <random>
+#include <iostream>
+#include <iterator>
 #include <stdexcept>
+#include <string_view>
+#include <unordered_set>
 
 #include <sqlite3.h>
 
-namespace message {
+#include "db/archive.hpp"
+#include "db/id.hpp"
+#include "db/sha256.hpp"
 
-static std::string random_id() {
-  static thread_local std::mt19937_64 rng{std::random_device{}()};
-  std::uniform_int_distribution<std::uint64_t> dist;
-  auto a = dist(rng);
-  auto b = dist(rng);
-  char buf[33];
-  std::snprintf(buf, sizeof(buf), "%016llx%016llx", (unsigned long long)a, (unsigned long long)b);
-  return std::string(buf);
-}
+namespace message {
 
 static const char* role_db(Role r) {
   switch (r) {
@@ -28,7 +27,36 @@ static const char* role_db(Role r) {
   return "user";
 }
 
-Service::Service(db::Db& db) : db_(db) {}
+Service::Service(db::Pool& pool, Options opts) : pool_(pool), opts_(opts) {
+  if (opts_.write_behind) writer_ = std::thread(&Service::writer_loop, this);
+}
+
+Service::~Service() {
+  // Queued async calls capture `this`.
+  pool_.executor().drain();
+
+  if (!writer_.joinable()) return;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    stopping_ = true;
+  }
+  work_cv_.notify_one();
+  writer_.join();
+
+  // The writer commits everything queued before exiting; each failed message
+  // was already logged, but a caller that never flushed hasn't seen it.
+  if (!write_error_.empty()) {
+    report("message write-behind lost messages: " + write_error_);
+  }
+}
+
+void Service::report(const std::string& error) {
+  if (opts_.log) {
+    opts_.log->error(error);
+  } else {
+    std::cerr << error << "\n";
+  }
+}
 
 Message Service::create_user(const std::string& session_id, std::string content) {
   return create(session_id, Role::User, std::move(content));
@@ -44,68 +72,573 @@ Message Service::create(const std::string& session_id, Role role, std::string co
                  .count();
 
   Message m;
-  m.id = random_id();
+  m.id = db::new_id();
   m.session_id = session_id;
   m.role = role;
   m.content = std::move(content);
   m.created_at = (std::int64_t)now;
+  // Decided here so the cache and queued reads can show the stored form
+  // before the row commits.
+  if (opts_.blob_threshold > 0 && m.content.size() >= opts_.blob_threshold) {
+    m.blob_hash = db::sha256_hex(m.content);
+  }
 
-  sqlite3_stmt* stmt = nullptr;
-  const char* sql =
-      "INSERT INTO messages(id, session_id, role, content, created_at) VALUES(?, ?, ?, ?, ?);";
-  if (sqlite3_prepare_v2(db_.get(), sql, -1, &stmt, nullptr) != SQLITE_OK) {
-    throw std::runtime_error(sqlite3_errmsg(db_.get()));
+  if (opts_.write_behind) {
+    bool wake = false;
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      pending_.push_back(m);
+      enqueued_++;
+      wake = pending_.size() == 1 || pending_.size() >= opts_.max_batch;
+    }
+    if (wake) work_cv_.notify_one();
+  } else {
+    insert(m);
   }
+  cache_append(stored_form(m));
+
+  broker_.publish(pubsub::EventType::Created, m);
+
+  return m;
+}
+
+std::string_view utf8_prefix(std::string_view s, std::size_t n) {
+  if (s.size() <= n) return s;
+  while (n > 0 && ((unsigned char)s[n] & 0xC0) == 0x80) n--;
+  return s.substr(0, n);
+}
+
+// What reading the row back yields: blob-backed content cut to its preview.
+Message Service::stored_form(const Message& m) const {
+  if (m.blob_hash.empty() || m.partial) return m;
+  Message out = m;
+  out.content = std::string(utf8_prefix(m.content, opts_.preview_bytes));
+  out.partial = true;
+  return out;
+}
+
+void Service::insert(const Message& m) {
+  auto writer = pool_.writer();
+  auto& db = *writer;
+  if (m.blob_hash.empty()) {
+    insert_row(db, m, m.content, {});
+    return;
+  }
+
+  // The blob and the row referencing it commit together or not at all. A
+  // savepoint nests inside the write-behind batch transaction too. `writer`
+  // is held until it is released, so no other thread's statements land
+  // inside it.
+  db.exec("SAVEPOINT message_blob;");
+  try {
+    db::put_blob(db, m.content, m.blob_hash);
+    insert_row(db, m, utf8_prefix(m.content, opts_.preview_bytes), m.blob_hash);
+    db.exec("RELEASE message_blob;");
+  } catch (...) {
+    db.exec("ROLLBACK TO message_blob;");
+    db.exec("RELEASE message_blob;");
+    throw;
+  }
+}
+
+void Service::insert_row(db::Db& db, const Message& m, std::string_view content,
+                         const std::string& blob_hash) {
+  const char* sql =
+      "INSERT INTO messages(id, session_id, role, content, created_at, blob_hash) "
+      "VALUES(?, ?, ?, ?, ?, ?);";
+  auto stmt = db.prepare(sql);
 
   sqlite3_bind_text(stmt, 1, m.id.c_str(), -1, SQLITE_TRANSIENT);
   sqlite3_bind_text(stmt, 2, m.session_id.c_str(), -1, SQLITE_TRANSIENT);
-  sqlite3_bind_text(stmt, 3, role_db(role), -1, SQLITE_TRANSIENT);
-  sqlite3_bind_text(stmt, 4, m.content.c_str(), -1, SQLITE_TRANSIENT);
+  sqlite3_bind_text(stmt, 3, role_db(m.role), -1, SQLITE_TRANSIENT);
+  sqlite3_bind_text(stmt, 4, content.data(), (int)content.size(), SQLITE_TRANSIENT);
   sqlite3_bind_int64(stmt, 5, m.created_at);
+  if (blob_hash.empty()) {
+    sqlite3_bind_null(stmt, 6);
+  } else {
+    sqlite3_bind_text(stmt, 6, blob_hash.c_str(), -1, SQLITE_TRANSIENT);
+  }
 
   int rc = sqlite3_step(stmt);
-  sqlite3_finalize(stmt);
-  if (rc != SQLITE_DONE) throw std::runtime_error(sqlite3_errmsg(db_.get()));
+  if (rc != SQLITE_DONE) throw std::runtime_error(sqlite3_errmsg(db.get()));
+}
 
-  broker_.publish(pubsub::EventType::Created, m);
+std::string Service::full_content(const Message& m) {
+  if (!m.partial) return m.content;
+  // A queued write-behind message has no committed blob yet.
+  if (opts_.write_behind) {
+    std::lock_guard<std::mutex> lk(mu_);
+    for (const auto& p : pending_) {
+      if (p.id == m.id) return p.content;
+    }
+  }
+  return open_content(m).read_all();
+}
+
+db::BlobReader Service::open_content(const Message& m) {
+  if (m.blob_hash.empty()) throw std::runtime_error("message has no stored blob: " + m.id);
+  return db::BlobReader(pool_.reader(), m.blob_hash);
+}
 
+void Service::writer_loop() {
+  std::unique_lock<std::mutex> lk(mu_);
+  while (true) {
+    work_cv_.wait(lk, [&] { return stopping_ || !pending_.empty(); });
+    if (pending_.empty()) return;  // stopping with nothing left to write
+
+    // Give the batch up to max_delay to fill, unless someone is waiting on it.
+    auto deadline = std::chrono::steady_clock::now() + opts_.max_delay;
+    work_cv_.wait_until(lk, deadline, [&] {
+      return stopping_ || flush_requested_ || pending_.size() >= opts_.max_batch;
+    });
+    flush_requested_ = false;
+
+    // Entries stay in pending_ (visible to list()) until committed; only this
+    // thread removes them, so copying the front is safe after unlocking.
+    std::size_t n = std::min(pending_.size(), opts_.max_batch);
+    std::vector<Message> batch(pending_.begin(), pending_.begin() + (std::ptrdiff_t)n);
+    lk.unlock();
+
+    // Messages that could not be written, as "id: error".
+    std::vector<std::string> failed;
+    std::vector<std::string> failed_sessions;
+    try {
+      // Held for the whole transaction so no other thread's writes join it.
+      auto writer = pool_.writer();
+      auto& db = *writer;
+      db.exec("BEGIN IMMEDIATE;");
+      try {
+        for (const auto& m : batch) insert(m);
+        db.exec("COMMIT;");
+      } catch (...) {
+        db.exec("ROLLBACK;");
+        // One bad row (e.g. its session was deleted or archived meanwhile)
+        // must not take the rest of the batch with it: replay it one row
+        // per savepoint and keep what goes in.
+        db.exec("BEGIN IMMEDIATE;");
+        try {
+          for (const auto& m : batch) {
+            db.exec("SAVEPOINT write_behind_row;");
+            try {
+              insert(m);
+              db.exec("RELEASE write_behind_row;");
+            } catch (const std::exception& e) {
+              db.exec("ROLLBACK TO write_behind_row; RELEASE write_behind_row;");
+              failed.push_back(m.id + ": " + e.what());
+              failed_sessions.push_back(m.session_id);
+            }
+          }
+          db.exec("COMMIT;");
+        } catch (...) {
+          db.exec("ROLLBACK;");
+          throw;
+        }
+      }
+    } catch (const std::exception& e) {
+      failed.clear();
+      failed_sessions.clear();
+      for (const auto& m : batch) {
+        failed.push_back(m.id + ": " + e.what());
+        failed_sessions.push_back(m.session_id);
+      }
+    }
+    for (const auto& f : failed) report("message write-behind failed for " + f);
+
+    lk.lock();
+    pending_.erase(pending_.begin(), pending_.begin() + (std::ptrdiff_t)n);
+    done_ += n;
+    for (const auto& f : failed) {
+      if (!write_error_.empty()) write_error_ += "; ";
+      write_error_ += f;
+    }
+    // The failed rows were already appended to cached histories.
+    for (const auto& id : failed_sessions) evict(id);
+    done_cv_.notify_all();
+  }
+}
+
+void Service::flush() {
+  if (!opts_.write_behind) return;
+  std::unique_lock<std::mutex> lk(mu_);
+  auto target = enqueued_;
+  if (done_ < target) {
+    flush_requested_ = true;
+    work_cv_.notify_one();
+    done_cv_.wait(lk, [&] { return done_ >= target; });
+  }
+  if (!write_error_.empty()) {
+    auto error = std::move(write_error_);
+    write_error_.clear();
+    throw std::runtime_error("message write-behind failed for " + error);
+  }
+}
+
+// Reads id, session_id, role, content, created_at, blob_hash starting at
+// column `col`.
+static Message read_message(sqlite3_stmt* stmt, int col) {
+  Message m;
+  m.id = (const char*)sqlite3_column_text(stmt, col + 0);
+  m.session_id = (const char*)sqlite3_column_text(stmt, col + 1);
+  auto role = (const char*)sqlite3_column_text(stmt, col + 2);
+  m.role = (role && std::string(role) == "assistant") ? Role::Assistant : Role::User;
+  m.content = (const char*)sqlite3_column_text(stmt, col + 3);
+  m.created_at = sqlite3_column_int64(stmt, col + 4);
+  if (auto hash = (const char*)sqlite3_column_text(stmt, col + 5)) {
+    m.blob_hash = hash;
+    m.partial = true;
+  }
   return m;
 }
 
-std::vector<Message> Service::list(const std::string& session_id) {
+// Queued write-behind rows are newer than anything committed, so they belong
+// at the end. Any that committed between the snapshot and the table read are
+// already in `out` and skipped.
+static void merge_queued(std::vector<Message>& out, std::vector<Message> queued) {
+  if (queued.empty()) return;
+  std::unordered_set<std::string> seen;
+  for (std::size_t i = out.size() > queued.size() ? out.size() - queued.size() : 0; i < out.size(); i++) {
+    seen.insert(out[i].id);
+  }
+  for (auto& m : queued) {
+    if (!seen.contains(m.id)) out.push_back(std::move(m));
+  }
+}
+
+// Must be taken before reading the table, so a batch committed in between
+// shows up in both (and is de-duplicated), never in neither.
+std::vector<Message> Service::queued_for(const std::string& session_id) {
+  std::vector<Message> queued;
+  if (!opts_.write_behind) return queued;
+  std::lock_guard<std::mutex> lk(mu_);
+  for (const auto& m : pending_) {
+    if (m.session_id == session_id) queued.push_back(stored_form(m));
+  }
+  return queued;
+}
+
+static void read_rows(db::Db& db, sqlite3_stmt* stmt, std::vector<Message>& out) {
+  while (true) {
+    int rc = sqlite3_step(stmt);
+    if (rc == SQLITE_ROW) {
+      out.push_back(read_message(stmt, 0));
+      continue;
+    }
+    if (rc == SQLITE_DONE) return;
+    throw std::runtime_error(sqlite3_errmsg(db.get()));
+  }
+}
+
+// The queries behind list(), list_page() and tail(), run against either the
+// hot database or an archive file (same columns and index).
+static std::vector<Message> select_all(db::Db& db, const std::string& session_id) {
+  const char* sql =
+      "SELECT id, session_id, role, content, created_at, blob_hash FROM messages WHERE session_id = ? "
+      "ORDER BY id ASC;";
+  auto stmt = db.prepare(sql);
+  sqlite3_bind_text(stmt, 1, session_id.c_str(), -1, SQLITE_TRANSIENT);
   std::vector<Message> out;
+  read_rows(db, stmt, out);
+  return out;
+}
 
-  sqlite3_stmt* stmt = nullptr;
+static Page select_page(db::Db& db, const std::string& session_id, const Cursor& after,
+                        std::size_t limit) {
+  // Seeks idx_messages_session_id straight to the cursor. One extra row is
+  // fetched to tell whether another page exists.
   const char* sql =
-      "SELECT id, session_id, role, content, created_at FROM messages WHERE session_id = ? "
-      "ORDER BY created_at ASC;";
-  if (sqlite3_prepare_v2(db_.get(), sql, -1, &stmt, nullptr) != SQLITE_OK) {
-    throw std::runtime_error(sqlite3_errmsg(db_.get()));
+      "SELECT id, session_id, role, content, created_at, blob_hash FROM messages "
+      "WHERE session_id = ?1 AND id > ?2 ORDER BY id ASC LIMIT ?3;";
+  auto stmt = db.prepare(sql);
+  sqlite3_bind_text(stmt, 1, session_id.c_str(), -1, SQLITE_TRANSIENT);
+  sqlite3_bind_text(stmt, 2, after.id.c_str(), -1, SQLITE_TRANSIENT);
+  sqlite3_bind_int64(stmt, 3, (sqlite3_int64)limit + 1);
+
+  Page page;
+  page.next = after;
+  read_rows(db, stmt, page.messages);
+  if (page.messages.size() > limit) {
+    page.messages.pop_back();
+    page.has_more = true;
   }
+  if (!page.messages.empty()) page.next = Cursor{page.messages.back().id};
+  return page;
+}
+
+static std::vector<Message> select_tail(db::Db& db, const std::string& session_id,
+                                        std::size_t n) {
+  const char* sql =
+      "SELECT id, session_id, role, content, created_at, blob_hash FROM messages WHERE session_id = ? "
+      "ORDER BY id DESC LIMIT ?;";
+  auto stmt = db.prepare(sql);
   sqlite3_bind_text(stmt, 1, session_id.c_str(), -1, SQLITE_TRANSIENT);
+  sqlite3_bind_int64(stmt, 2, (sqlite3_int64)n);
+  std::vector<Message> out;
+  read_rows(db, stmt, out);
+  std::reverse(out.begin(), out.end());
+  return out;
+}
+
+// Only checked once the hot table has nothing for the session, so live
+// sessions pay no extra lookup beyond the empty case.
+std::optional<db::Db> Service::open_archive(db::Db& db, const std::string& session_id) {
+  if (pool_.data_dir().empty()) return std::nullopt;
+  auto period = db::archived_period(db, session_id);
+  if (period.empty()) return std::nullopt;
+  return db::connect_archive(db::archive_path(pool_.data_dir(), period));
+}
+
+std::vector<Message> Service::list(const std::string& session_id) {
+  std::vector<Message> out;
+  std::uint64_t version = 0;
+  if (cache_get(session_id, out, version)) return out;
+  auto queued = queued_for(session_id);
+
+  {
+    auto db = pool_.reader();
+    out = select_all(*db, session_id);
+    // Archived rows aren't cached: restore() moves them back behind the
+    // cache's back.
+    if (out.empty() && queued.empty()) {
+      if (auto archive = open_archive(*db, session_id)) return select_all(*archive, session_id);
+    }
+  }
+
+  merge_queued(out, std::move(queued));
+  cache_put(session_id, out, version);
+  return out;
+}
+
+Page Service::list_page(const std::string& session_id, Cursor after, std::size_t limit) {
+  if (limit == 0) return Page{};
+
+  auto db = pool_.reader();
+  Page page = select_page(*db, session_id, after, limit);
+  if (page.messages.empty()) {
+    if (auto archive = open_archive(*db, session_id)) {
+      return select_page(*archive, session_id, after, limit);
+    }
+  }
+  return page;
+}
+
+std::vector<Message> Service::tail(const std::string& session_id, std::size_t n) {
+  std::vector<Message> out;
+  if (n == 0) return out;
+  std::uint64_t version = 0;
+  if (cache_get(session_id, out, version)) {
+    if (out.size() > n) out.erase(out.begin(), out.end() - (std::ptrdiff_t)n);
+    return out;
+  }
+  auto queued = queued_for(session_id);
+
+  {
+    auto db = pool_.reader();
+    out = select_tail(*db, session_id, n);
+    if (out.empty() && queued.empty()) {
+      if (auto archive = open_archive(*db, session_id)) return select_tail(*archive, session_id, n);
+    }
+  }
+
+  merge_queued(out, std::move(queued));
+  if (out.size() > n) out.erase(out.begin(), out.end() - (std::ptrdiff_t)n);
+  return out;
+}
+
+static std::size_t message_bytes(const Message& m) {
+  return sizeof(Message) + m.id.capacity() + m.session_id.capacity() + m.content.capacity() +
+         m.blob_hash.capacity();
+}
+
+bool Service::cache_get(const std::string& session_id, std::vector<Message>& out,
+                        std::uint64_t& version) {
+  if (opts_.cache_bytes == 0) return false;
+  std::lock_guard<std::mutex> lk(cache_mu_);
+  auto it = cache_.find(session_id);
+  if (it == cache_.end()) {
+    cache_stats_.misses++;
+    version = cache_version_;
+    return false;
+  }
+  cache_stats_.hits++;
+  cache_lru_.splice(cache_lru_.begin(), cache_lru_, it->second.lru);
+  out = it->second.messages;
+  return true;
+}
+
+void Service::cache_put(const std::string& session_id, std::vector<Message> messages,
+                        std::uint64_t version) {
+  if (opts_.cache_bytes == 0) return;
+  std::size_t bytes = 0;
+  for (const auto& m : messages) bytes += message_bytes(m);
+  if (bytes > opts_.cache_bytes) return;
+
+  std::lock_guard<std::mutex> lk(cache_mu_);
+  // A create() since the read may be missing from `messages`.
+  if (version != cache_version_ || cache_.contains(session_id)) return;
+
+  cache_lru_.push_front(session_id);
+  cache_.emplace(session_id, CacheEntry{std::move(messages), bytes, cache_lru_.begin()});
+  cache_size_ += bytes;
+  cache_trim();
+}
+
+void Service::cache_append(const Message& m) {
+  if (opts_.cache_bytes == 0) return;
+  std::lock_guard<std::mutex> lk(cache_mu_);
+  cache_version_++;
+  auto it = cache_.find(m.session_id);
+  if (it == cache_.end()) return;
+
+  // Concurrent create() calls can get here out of id order.
+  auto& e = it->second;
+  auto pos = e.messages.end();
+  while (pos != e.messages.begin() && std::prev(pos)->id > m.id) --pos;
+  e.messages.insert(pos, m);
+
+  auto bytes = message_bytes(m);
+  e.bytes += bytes;
+  cache_size_ += bytes;
+  cache_lru_.splice(cache_lru_.begin(), cache_lru_, e.lru);
+  cache_trim();
+}
+
+// Caller holds cache_mu_.
+void Service::cache_trim() {
+  while (cache_size_ > opts_.cache_bytes && !cache_lru_.empty()) {
+    auto it = cache_.find(cache_lru_.back());
+    cache_size_ -= it->second.bytes;
+    cache_.erase(it);
+    cache_lru_.pop_back();
+    cache_stats_.evictions++;
+  }
+}
+
+void Service::cache_clear() {
+  std::lock_guard<std::mutex> lk(cache_mu_);
+  cache_.clear();
+  cache_lru_.clear();
+  cache_size_ = 0;
+  cache_version_++;
+}
+
+void Service::evict(const std::string& session_id) {
+  std::lock_guard<std::mutex> lk(cache_mu_);
+  cache_version_++;
+  auto it = cache_.find(session_id);
+  if (it == cache_.end()) return;
+  cache_size_ -= it->second.bytes;
+  cache_lru_.erase(it->second.lru);
+  cache_.erase(it);
+}
+
+CacheStats Service::cache_stats() {
+  std::lock_guard<std::mutex> lk(cache_mu_);
+  CacheStats out = cache_stats_;
+  out.sessions = cache_.size();
+  out.bytes = cache_size_;
+  return out;
+}
+
+// Quotes every term so user input can't inject FTS5 operators.
+static std::string fts_query(const std::string& query) {
+  std::string out;
+  std::size_t i = 0;
+  while (i < query.size()) {
+    while (i < query.size() && std::isspace((unsigned char)query[i])) i++;
+    if (i >= query.size()) break;
+    if (!out.empty()) out += ' ';
+    out += '"';
+    while (i < query.size() && !std::isspace((unsigned char)query[i])) {
+      if (query[i] == '"') out += '"';
+      out += query[i++];
+    }
+    out += '"';
+  }
+  if (!out.empty()) out += '*';
+  return out;
+}
+
+std::vector<SearchHit> Service::search(const std::string& query, std::size_t limit) {
+  std::vector<SearchHit> out;
+  auto match = fts_query(query);
+  if (match.empty() || limit == 0) return out;
+
+  // ORDER BY rank with a LIMIT lets FTS5 keep only the top hits while scanning
+  // the posting lists; the join then touches just those rows.
+  const char* sql =
+      "SELECT m.id, m.session_id, m.role, "
+      "snippet(messages_fts, 0, '[', ']', '...', 16), messages_fts.rank, m.created_at "
+      "FROM messages_fts JOIN messages m ON m.seq = messages_fts.rowid "
+      "WHERE messages_fts MATCH ?1 ORDER BY messages_fts.rank LIMIT ?2;";
+  auto db = pool_.reader();
+  auto stmt = db->prepare(sql);
+  sqlite3_bind_text(stmt, 1, match.c_str(), -1, SQLITE_TRANSIENT);
+  sqlite3_bind_int64(stmt, 2, (sqlite3_int64)limit);
 
   while (true) {
     int rc = sqlite3_step(stmt);
     if (rc == SQLITE_ROW) {
-      Message m;
-      m.id = (const char*)sqlite3_column_text(stmt, 0);
-      m.session_id = (const char*)sqlite3_column_text(stmt, 1);
+      SearchHit h;
+      h.message_id = (const char*)sqlite3_column_text(stmt, 0);
+      h.session_id = (const char*)sqlite3_column_text(stmt, 1);
       auto role = (const char*)sqlite3_column_text(stmt, 2);
-      m.role = (role && std::string(role) == "assistant") ? Role::Assistant : Role::User;
-      m.content = (const char*)sqlite3_column_text(stmt, 3);
-      m.created_at = sqlite3_column_int64(stmt, 4);
-      out.push_back(std::move(m));
+      h.role = (role && std::string(role) == "assistant") ? Role::Assistant : Role::User;
+      auto snippet = (const char*)sqlite3_column_text(stmt, 3);
+      h.snippet = snippet ? snippet : "";
+      h.score = sqlite3_column_double(stmt, 4);
+      h.created_at = sqlite3_column_int64(stmt, 5);
+      out.push_back(std::move(h));
       continue;
     }
     if (rc == SQLITE_DONE) break;
-    sqlite3_finalize(stmt);
-    throw std::runtime_error(sqlite3_errmsg(db_.get()));
+    throw std::runtime_error(sqlite3_errmsg(db->get()));
   }
 
-  sqlite3_finalize(stmt);
   return out;
 }
 
+std::future<Message> Service::async_create_user(std::string session_id, std::string content) {
+  return pool_.executor().submit(
+      [this, session_id = std::move(session_id), content = std::move(content)]() mutable {
+        return create_user(session_id, std::move(content));
+      });
+}
+
+std::future<Message> Service::async_create_assistant(std::string session_id,
+                                                     std::string content) {
+  return pool_.executor().submit(
+      [this, session_id = std::move(session_id), content = std::move(content)]() mutable {
+        return create_assistant(session_id, std::move(content));
+      });
+}
+
+std::future<std::vector<Message>> Service::async_list(std::string session_id) {
+  return pool_.executor().submit(
+      [this, session_id = std::move(session_id)] { return list(session_id); });
+}
+
+std::future<Page> Service::async_list_page(std::string session_id, Cursor after,
+                                           std::size_t limit) {
+  return pool_.executor().submit(
+      [this, session_id = std::move(session_id), after = std::move(after), limit] {
+        return list_page(session_id, after, limit);
+      });
+}
+
+std::future<std::vector<Message>> Service::async_tail(std::string session_id, std::size_t n) {
+  return pool_.executor().submit(
+      [this, session_id = std::move(session_id), n] { return tail(session_id, n); });
+}
+
+std::future<std::vector<SearchHit>> Service::async_search(std::string query, std::size_t limit) {
+  return pool_.executor().submit(
+      [this, query = std::move(query), limit] { return search(query, limit); });
+}
+
+std::future<std::string> Service::async_full_content(Message m) {
+  return pool_.executor().submit([this, m = std::move(m)] { return full_content(m); });
+}
+
 std::string role_to_string(Role r) {
   switch (r) {
     case Role::User:
@@ -116,8 +649,25 @@ std::string role_to_string(Role r) {
   return "user";
 }
 
-std::shared_ptr<pubsub::Channel<pubsub::Event<Message>>> Service::subscribe() {
+pubsub::EventSubscription<Message> Service::subscribe() {
   return broker_.subscribe();
 }
 
+pubsub::SharedSubscription<Message> Service::subscribe_shared(
+    pubsub::SubscribeOptions opts) {
+  return broker_.subscribe_shared(opts);
+}
+
+static const std::string& session_of(const Message& m) { return m.session_id; }
+
+pubsub::EventSubscription<Message> Service::subscribe(
+    const std::string& session_id) {
+  return broker_.subscribe(pubsub::Filter<Message>{&session_of, session_id});
+}
+
+pubsub::SharedSubscription<Message> Service::subscribe_shared(
+    const std::string& session_id) {
+  return broker_.subscribe_shared(pubsub::Filter<Message>{&session_of, session_id});
+}
+
 }  // namespace message
@@ -1,10 +1,22 @@
 #pragma once
 
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
+#include <future>
+#include <list>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
-#include "db/db.hpp"
+#include "db/blob.hpp"
+#include "db/pool.hpp"
+#include "logging/logger.hpp"
 #include "pubsub/broker.hpp"
 
 namespace message {
@@ -20,26 +32,191 @@ struct Message {
   Role role;
   std::string content;
   std::int64_t created_at = 0;
+  // Set when the full content is stored as a blob (see Options::blob_threshold).
+  std::string blob_hash;
+  // content is only a preview; use Service::full_content() for the rest.
+  bool partial = false;
+};
+
+// Position in a session's history for keyset pagination: the id of the last
+// message seen (ids are time-ordered). A default Cursor is "before the first
+// message".
+struct Cursor {
+  std::string id;
+};
+
+struct Page {
+  std::vector<Message> messages;
+  // Pass back to list_page() to continue after the last message returned.
+  Cursor next;
+  bool has_more = false;
+};
+
+struct SearchHit {
+  std::string message_id;
+  std::string session_id;
+  Role role;
+  // Matching fragment of the content with hits wrapped in [ ].
+  std::string snippet;
+  // bm25 relevance; lower is better.
+  double score = 0;
+  std::int64_t created_at = 0;
+};
+
+struct Options {
+  // Queue inserts and commit them from a background thread in batched
+  // transactions. Events are still published (and list() still sees the
+  // message) as soon as create() returns.
+  bool write_behind = false;
+  // Longest a queued message waits before its batch is committed.
+  std::chrono::milliseconds max_delay{50};
+  // Largest number of messages committed in one transaction.
+  std::size_t max_batch = 256;
+  // Content at least this large is stored once in the blob store and the
+  // messages row keeps only the first preview_bytes of it. 0 disables.
+  std::size_t blob_threshold = 16 * 1024;
+  std::size_t preview_bytes = 512;
+  // Memory budget for the per-session LRU cache behind list() and tail().
+  // 0 disables it.
+  std::size_t cache_bytes = 8 * 1024 * 1024;
+  // Where failed write-behind batches are reported; stderr if null.
+  logging::Logger* log = nullptr;
+};
+
+struct CacheStats {
+  std::uint64_t hits = 0;
+  std::uint64_t misses = 0;
+  std::uint64_t evictions = 0;
+  std::size_t sessions = 0;
+  std::size_t bytes = 0;
 };
 
 class Service {
  public:
-  explicit Service(db::Db& db);
+  explicit Service(db::Pool& pool, Options opts = {});
+  ~Service();
+
+  Service(const Service&) = delete;
+  Service& operator=(const Service&) = delete;
 
   Message create_user(const std::string& session_id, std::string content);
   Message create_assistant(const std::string& session_id, std::string content);
 
+  // list(), list_page() and tail() read an archived session's rows from its
+  // archive file (see session::Service::archive_idle()). Blob-backed messages
+  // there stay previews: full_content() and open_content() need restore().
   std::vector<Message> list(const std::string& session_id);
 
-  std::shared_ptr<pubsub::Channel<pubsub::Event<Message>>> subscribe();
+  // Up to `limit` messages strictly after `after`, oldest first. Reads only
+  // committed rows, so write-behind messages appear once their batch commits.
+  Page list_page(const std::string& session_id, Cursor after, std::size_t limit);
+
+  // The newest `n` messages (including queued write-behind rows), oldest first.
+  std::vector<Message> tail(const std::string& session_id, std::size_t n);
+
+  // Full-text search across all sessions, best match first. Each
+  // whitespace-separated word in `query` must appear (prefix match on the
+  // last one); FTS5 syntax characters are treated literally. Archived
+  // sessions aren't indexed and don't match.
+  std::vector<SearchHit> search(const std::string& query, std::size_t limit);
+
+  // The message's complete content, reading it from the blob store (or the
+  // write-behind queue, before it commits) if m is only a preview.
+  std::string full_content(const Message& m);
+
+  // Streams the stored blob behind m without loading it whole. Throws
+  // std::runtime_error if m has no committed blob.
+  db::BlobReader open_content(const Message& m);
+
+  // Blocks until every message created so far is committed. Throws
+  // std::runtime_error naming each message id that failed to be written since
+  // the last flush; the rest of its batch is still committed.
+  void flush();
+
+  // The same operations run on the pool's db::Executor, for callers (the UI)
+  // that must not block on SQLite. Errors arrive through the future.
+  std::future<Message> async_create_user(std::string session_id, std::string content);
+  std::future<Message> async_create_assistant(std::string session_id, std::string content);
+  std::future<std::vector<Message>> async_list(std::string session_id);
+  std::future<Page> async_list_page(std::string session_id, Cursor after, std::size_t limit);
+  std::future<std::vector<Message>> async_tail(std::string session_id, std::size_t n);
+  std::future<std::vector<SearchHit>> async_search(std::string query, std::size_t limit);
+  std::future<std::string> async_full_content(Message m);
+
+  // Counters for the conversation cache, for sizing Options::cache_bytes.
+  CacheStats cache_stats();
+
+  // Drops a session's cached history, e.g. after its rows were moved or
+  // deleted behind this service's back.
+  void evict(const std::string& session_id);
+
+  pubsub::EventSubscription<Message> subscribe();
+  pubsub::SharedSubscription<Message> subscribe_shared(
+      pubsub::SubscribeOptions opts = {});
+
+  // Only receive events for messages in the given session.
+  pubsub::EventSubscription<Message> subscribe(const std::string& session_id);
+  pubsub::SharedSubscription<Message> subscribe_shared(
+      const std::string& session_id);
 
  private:
   Message create(const std::string& session_id, Role role, std::string content);
+  void insert(const Message& m);
+  Message stored_form(const Message& m) const;
+  void report(const std::string& error);
+  void insert_row(db::Db& db, const Message& m, std::string_view content,
+                  const std::string& blob_hash);
+  std::vector<Message> queued_for(const std::string& session_id);
+  void writer_loop();
+  std::optional<db::Db> open_archive(db::Db& db, const std::string& session_id);
+
+  // On a miss, `version` is what to pass to cache_put() after reading.
+  bool cache_get(const std::string& session_id, std::vector<Message>& out,
+                 std::uint64_t& version);
+  void cache_put(const std::string& session_id, std::vector<Message> messages,
+                 std::uint64_t version);
+  void cache_append(const Message& m);
+  void cache_clear();
+  void cache_trim();
 
-  db::Db& db_;
+  db::Pool& pool_;
+  Options opts_;
   pubsub::Broker<Message> broker_;
+
+  // Write-behind state. pending_ holds queued and in-flight messages in
+  // creation order; they are only removed once committed (or failed).
+  std::mutex mu_;
+  std::condition_variable work_cv_;
+  std::condition_variable done_cv_;
+  std::deque<Message> pending_;
+  std::uint64_t enqueued_ = 0;
+  std::uint64_t done_ = 0;
+  bool flush_requested_ = false;
+  bool stopping_ = false;
+  // "id: error" for each message lost since the last flush(), "; "-separated.
+  std::string write_error_;
+  std::thread writer_;
+
+  // Conversation cache: full list() results per session, most recently used
+  // at the front of cache_lru_. create() appends to sessions already cached.
+  struct CacheEntry {
+    std::vector<Message> messages;
+    std::size_t bytes = 0;
+    std::list<std::string>::iterator lru;
+  };
+  std::mutex cache_mu_;
+  std::unordered_map<std::string, CacheEntry> cache_;
+  std::list<std::string> cache_lru_;
+  std::size_t cache_size_ = 0;
+  // Bumped by every create(); a list() miss only fills the cache if no
+  // message was created while it read the table.
+  std::uint64_t cache_version_ = 0;
+  CacheStats cache_stats_;
 };
 
 std::string role_to_string(Role r);
 
+// At most n bytes from the front of s, cut at a UTF-8 character boundary.
+std::string_view utf8_prefix(std::string_view s, std::size_t n);
+
 }  // namespace message
@@ -9,8 +9,13 @@ namespace permission {
 
 Service::Service() : broker_() {}
 
-std::shared_ptr<pubsub::Channel<pubsub::Event<PermissionRequest>>> Service::subscribe() {
-  return broker_.subscribe();
+pubsub::EventSubscription<PermissionRequest> Service::subscribe(
+    pubsub::SubscribeOptions opts) {
+  return broker_.subscribe(opts);
+}
+
+std::vector<pubsub::SubscriberStats> Service::subscriber_stats() const {
+  return broker_.stats();
 }
 
 void Service::grant_persistent(const PermissionRequest& permission) {
@@ -46,7 +46,9 @@ class Service {
   Service();
   
   // Service interface
-  std::shared_ptr<pubsub::Channel<pubsub::Event<PermissionRequest>>> subscribe();
+  pubsub::EventSubscription<PermissionRequest> subscribe(
+      pubsub::SubscribeOptions opts = {});
+  std::vector<pubsub::SubscriberStats> subscriber_stats() const;
   
   void grant_persistent(const PermissionRequest& permission);
   void grant(const PermissionRequest& permission);
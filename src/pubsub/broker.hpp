@@ -1,14 +1,22 @@
 #pragma once
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <cstddef>
+#include <cstdint>
 #include <deque>
 #include <functional>
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <string>
+#include <thread>
 #include <unordered_map>
+#include <vector>
+
+#include "pubsub/ring_buffer.hpp"
 
 namespace pubsub {
 
@@ -24,13 +32,72 @@ struct Event {
   T payload;
 };
 
+// One immutable event shared by every subscriber that asked for it, so a
+// large payload is allocated once per publish instead of copied per queue.
+template <typename T>
+using SharedEvent = std::shared_ptr<const Event<T>>;
+
+// What a channel does with a new value once it holds high_water values.
+enum class Overflow {
+  Block,       // producers wait for room (bounded); unbounded channels just grow
+  DropOldest,  // evict the oldest queued value to make room
+  DropNewest,  // discard the value being pushed
+  Disconnect,  // close the channel; the broker then forgets the subscriber
+};
+
+// Per-subscription knobs for Broker::subscribe().
+struct SubscribeOptions {
+  // 0 keeps the unbounded deque channel; otherwise a bounded ring of (at least)
+  // this many slots is used.
+  std::size_t capacity = 0;
+  // Queue depth at which `overflow` applies. 0 means "when the ring is full"
+  // for bounded channels and "never" for unbounded ones.
+  std::size_t high_water = 0;
+  Overflow overflow = Overflow::Block;
+};
+
+struct ChannelStats {
+  std::size_t depth = 0;
+  std::uint64_t dropped = 0;
+  bool closed = false;
+};
+
 // Very small thread-safe queue used per-subscriber.
+//
+// By default this is an unbounded deque behind a mutex. When constructed with a
+// capacity it is backed by a lock-free RingBuffer instead: push/pop only touch
+// the mutex to park when the ring is full/empty, and producers skip the
+// notify entirely while nobody is parked.
 template <typename T>
 class Channel {
  public:
+  using value_type = T;
+
+  Channel() = default;
+  explicit Channel(std::size_t capacity) : Channel(SubscribeOptions{capacity}) {}
+  explicit Channel(SubscribeOptions opts) : high_water_(opts.high_water), overflow_(opts.overflow) {
+    if (opts.capacity > 0) ring_ = std::make_unique<RingBuffer<T>>(opts.capacity);
+  }
+
+  // Unbounded channels never block. Bounded channels block while full (with
+  // Overflow::Block) and drop the value if the channel is closed.
   void push(T v) {
+    if (ring_) {
+      push_bounded(v);
+      return;
+    }
     {
       std::lock_guard<std::mutex> lk(mu_);
+      if (high_water_ > 0 && q_.size() >= high_water_ && overflow_ != Overflow::Block) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        if (overflow_ == Overflow::DropNewest) return;
+        if (overflow_ == Overflow::Disconnect) {
+          closed_ = true;
+          cv_.notify_all();
+          return;
+        }
+        q_.pop_front();
+      }
       q_.push_back(std::move(v));
     }
     cv_.notify_one();
@@ -38,80 +105,459 @@ class Channel {
 
   // Blocking pop; returns std::nullopt if closed.
   std::optional<T> pop() {
-    std::unique_lock<std::mutex> lk(mu_);
-    cv_.wait(lk, [&] { return closed_ || !q_.empty(); });
+    return pop_wait([&](auto& lk, auto pred) { cv_.wait(lk, pred); });
+  }
+
+  // Like pop(), but also returns std::nullopt once the deadline passes.
+  template <typename Clock, typename Duration>
+  std::optional<T> pop_until(const std::chrono::time_point<Clock, Duration>& deadline) {
+    return pop_wait([&](auto& lk, auto pred) { cv_.wait_until(lk, deadline, pred); });
+  }
+
+  template <typename Rep, typename Period>
+  std::optional<T> pop_for(const std::chrono::duration<Rep, Period>& timeout) {
+    return pop_until(std::chrono::steady_clock::now() + timeout);
+  }
+
+  // Non-blocking pop; returns std::nullopt if nothing is queued.
+  std::optional<T> try_pop() {
+    if (ring_) {
+      auto v = ring_->try_pop();
+      if (v) wake(push_waiters_, not_full_);
+      return v;
+    }
+    std::lock_guard<std::mutex> lk(mu_);
     if (q_.empty()) return std::nullopt;
     T v = std::move(q_.front());
     q_.pop_front();
     return v;
   }
 
+  // Moves up to max_n queued values onto the end of out without blocking,
+  // taking the lock at most once. Returns how many were moved.
+  std::size_t drain(std::size_t max_n, std::vector<T>& out) {
+    std::size_t n = 0;
+    if (ring_) {
+      while (n < max_n) {
+        auto v = ring_->try_pop();
+        if (!v) break;
+        out.push_back(std::move(*v));
+        n++;
+      }
+      if (n > 0) wake(push_waiters_, not_full_, /*all=*/true);
+      return n;
+    }
+    std::lock_guard<std::mutex> lk(mu_);
+    while (n < max_n && !q_.empty()) {
+      out.push_back(std::move(q_.front()));
+      q_.pop_front();
+      n++;
+    }
+    return n;
+  }
+
   void close() {
     {
       std::lock_guard<std::mutex> lk(mu_);
       closed_ = true;
     }
     cv_.notify_all();
+    not_full_.notify_all();
+  }
+
+  bool closed() const { return closed_; }
+
+  std::size_t depth() const {
+    if (ring_) return ring_->size_approx();
+    std::lock_guard<std::mutex> lk(mu_);
+    return q_.size();
+  }
+
+  ChannelStats stats() const {
+    return ChannelStats{depth(), dropped_.load(std::memory_order_relaxed), closed_};
   }
 
+  // 0 for unbounded channels.
+  std::size_t capacity() const { return ring_ ? ring_->capacity() : 0; }
+
  private:
-  std::mutex mu_;
+  void push_bounded(T& v) {
+    if (closed_) return;
+    if (overflow_ != Overflow::Block) {
+      push_lossy(v);
+      return;
+    }
+    if (!spin([&] { return ring_->try_push(v); })) {
+      std::unique_lock<std::mutex> lk(mu_);
+      push_waiters_.fetch_add(1);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      bool pushed = false;
+      not_full_.wait(lk, [&] { return closed_ || (pushed = ring_->try_push(v)); });
+      push_waiters_.fetch_sub(1);
+      if (!pushed) return;
+    }
+    wake(pop_waiters_, cv_);
+  }
+
+  // Never blocks: applies overflow_ once the ring reaches high_water_ (or fills).
+  void push_lossy(T& v) {
+    bool over = high_water_ > 0 && ring_->size_approx() >= high_water_;
+    while (over || !ring_->try_push(v)) {
+      over = false;
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      if (overflow_ == Overflow::DropNewest) return;
+      if (overflow_ == Overflow::Disconnect) {
+        close();
+        return;
+      }
+      ring_->try_pop();  // DropOldest: make room and retry
+    }
+    wake(pop_waiters_, cv_);
+  }
+
+  // wait(lk, pred) blocks on cv_ until pred() holds (or gives up, for timed pops).
+  template <typename Wait>
+  std::optional<T> pop_wait(Wait&& wait) {
+    std::optional<T> v;
+    if (!ring_) {
+      std::unique_lock<std::mutex> lk(mu_);
+      wait(lk, [&] { return closed_ || !q_.empty(); });
+      if (q_.empty()) return std::nullopt;
+      v.emplace(std::move(q_.front()));
+      q_.pop_front();
+      return v;
+    }
+    if (!spin([&] { return (v = ring_->try_pop()).has_value(); })) {
+      std::unique_lock<std::mutex> lk(mu_);
+      pop_waiters_.fetch_add(1);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      wait(lk, [&] { return (v = ring_->try_pop()).has_value() || closed_; });
+      pop_waiters_.fetch_sub(1);
+      if (!v) return std::nullopt;
+    }
+    wake(push_waiters_, not_full_);
+    return v;
+  }
+
+  // Brief optimistic retry before parking; most empty/full states last only
+  // as long as it takes the other side to run.
+  template <typename F>
+  static bool spin(F&& attempt) {
+    for (int i = 0; i < k_spin_; i++) {
+      if (attempt()) return true;
+      std::this_thread::yield();
+    }
+    return attempt();
+  }
+
+  // Pairs with the fence in the parking paths above: either the waiter sees our
+  // ring update when it re-checks, or we see its waiter count and notify.
+  void wake(std::atomic<int>& waiters, std::condition_variable& cv, bool all = false) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters.load(std::memory_order_relaxed) == 0) return;
+    { std::lock_guard<std::mutex> lk(mu_); }
+    if (all) {
+      cv.notify_all();
+    } else {
+      cv.notify_one();
+    }
+  }
+
+  mutable std::mutex mu_;
   std::condition_variable cv_;
   std::deque<T> q_;
-  bool closed_ = false;
+  std::atomic<bool> closed_{false};
+
+  std::size_t high_water_ = 0;
+  Overflow overflow_ = Overflow::Block;
+  std::atomic<std::uint64_t> dropped_{0};
+
+  static constexpr int k_spin_ = 16;
+  std::unique_ptr<RingBuffer<T>> ring_;
+  std::condition_variable not_full_;
+  std::atomic<int> pop_waiters_{0};
+  std::atomic<int> push_waiters_{0};
+};
+
+// Restricts a subscription to events whose key_of(payload) == key, e.g. one
+// session's messages. Subscriptions sharing a key_of are routed through one
+// hash index, so publish only touches the channels for the event's key.
+template <typename T>
+struct Filter {
+  using KeyFn = const std::string& (*)(const T&);
+
+  KeyFn key_of = nullptr;
+  std::string key;
+};
+
+// RAII handle for a subscription: closes and releases the channel when it goes
+// out of scope. The broker stops delivering to a closed channel and drops its
+// own reference on its next publish.
+template <typename C>
+class Subscription {
+ public:
+  Subscription() = default;
+  explicit Subscription(std::shared_ptr<C> ch) : ch_(std::move(ch)) {}
+  Subscription(const Subscription&) = delete;
+  Subscription& operator=(const Subscription&) = delete;
+  Subscription(Subscription&&) noexcept = default;
+  Subscription& operator=(Subscription&& other) noexcept {
+    if (this != &other) {
+      reset();
+      ch_ = std::move(other.ch_);
+    }
+    return *this;
+  }
+  ~Subscription() { reset(); }
+
+  void reset() {
+    if (!ch_) return;
+    ch_->close();
+    ch_.reset();
+  }
+
+  C* operator->() const { return ch_.get(); }
+  C& operator*() const { return *ch_; }
+  const std::shared_ptr<C>& channel() const { return ch_; }
+  explicit operator bool() const { return ch_ != nullptr; }
+
+ private:
+  std::shared_ptr<C> ch_;
+};
+
+// What Broker<T>::subscribe() and subscribe_shared() return.
+template <typename T>
+using EventSubscription = Subscription<Channel<Event<T>>>;
+template <typename T>
+using SharedSubscription = Subscription<Channel<SharedEvent<T>>>;
+
+// Per-subscriber diagnostics, see Broker::stats().
+struct SubscriberStats {
+  std::size_t id = 0;
+  std::string key;  // filter key, empty for unfiltered subscribers
+  std::size_t capacity = 0;
+  ChannelStats channel;
 };
 
 // Broker allows clients to publish events and subscribe to events.
-// This mirrors the Go design, but returns a shared Channel instead of a Go channel.
+// This mirrors the Go design, but returns a Subscription owning a Channel
+// instead of a Go channel.
+//
+// The subscriber set is an immutable snapshot replaced wholesale (RCU style)
+// on subscribe/unsubscribe/shutdown, so publish never copies it, never
+// allocates for it and never touches mu_; mu_ only serializes writers. The
+// snapshot owns its channels, so publish pays one refcount bump for the
+// snapshot itself, not one per subscriber. (That load is not lock-free:
+// libstdc++ guards atomic<shared_ptr> with a short internal spin lock.)
+//
+// subscribe_shared() subscribers receive SharedEvent<T> and all share one
+// payload allocation per publish. subscribe() subscribers keep receiving
+// Event<T> by value; for them the shared event is copied out at push time.
+//
+// Subscribers whose channel was closed (by its Subscription going away,
+// unsubscribe(), or their Overflow policy disconnecting them) are pruned after
+// the publish that notices them.
 template <typename T>
 class Broker {
  public:
   using EventT = Event<T>;
   using ChannelT = Channel<EventT>;
+  using SharedChannelT = Channel<SharedEvent<T>>;
 
-  std::shared_ptr<ChannelT> subscribe() {
-    std::lock_guard<std::mutex> lk(mu_);
-    if (shutdown_) {
-      auto ch = std::make_shared<ChannelT>();
-      ch->close();
-      return ch;
-    }
-    auto ch = std::make_shared<ChannelT>();
-    subs_[next_id_++] = ch;
-    return ch;
+  EventSubscription<T> subscribe(SubscribeOptions opts = {}) {
+    return subscribe(Filter<T>{}, opts);
+  }
+
+  EventSubscription<T> subscribe(Filter<T> filter, SubscribeOptions opts = {}) {
+    auto ch = std::make_shared<ChannelT>(opts);
+    add(Sub{0, ch, {}, std::move(filter), false});
+    return EventSubscription<T>(std::move(ch));
+  }
+
+  SharedSubscription<T> subscribe_shared(SubscribeOptions opts = {}) {
+    return subscribe_shared(Filter<T>{}, opts);
+  }
+
+  SharedSubscription<T> subscribe_shared(Filter<T> filter, SubscribeOptions opts = {}) {
+    auto ch = std::make_shared<SharedChannelT>(opts);
+    add(Sub{0, {}, ch, std::move(filter), true});
+    return SharedSubscription<T>(std::move(ch));
+  }
+
+  // Stops delivering to ch and closes it. Unknown channels are ignored.
+  void unsubscribe(const std::shared_ptr<ChannelT>& ch) {
+    remove([&](const Sub& s) { return s.copy == ch; });
+    ch->close();
+  }
+
+  void unsubscribe(const std::shared_ptr<SharedChannelT>& ch) {
+    remove([&](const Sub& s) { return s.shared == ch; });
+    ch->close();
   }
 
   void shutdown() {
-    std::unordered_map<std::size_t, std::shared_ptr<ChannelT>> subs_copy;
+    std::shared_ptr<const Snapshot> old;
     {
       std::lock_guard<std::mutex> lk(mu_);
       shutdown_ = true;
-      subs_copy = subs_;
-      subs_.clear();
+      old = snapshot_.exchange(std::make_shared<const Snapshot>());
     }
-    for (auto& [_, ch] : subs_copy) {
-      ch->close();
+    for (auto& s : old->subs) {
+      s.close();
     }
   }
 
   void publish(EventType type, T payload) {
-    std::unordered_map<std::size_t, std::shared_ptr<ChannelT>> subs_copy;
+    auto snap = snapshot_.load(std::memory_order_acquire);
+    if (snap->subs.empty()) return;
+
+    // The event stays on the stack until the first shared subscriber needs
+    // it; after that, copy subscribers read from the shared allocation.
+    EventT local{type, std::move(payload)};
+    SharedEvent<T> shared;
+    const EventT* ev = &local;
+    bool stale = false;
+    // The snapshot owns its channels, so no per-subscriber refcount is
+    // touched here.
+    auto deliver = [&](const Sub& s) {
+      if (!s.is_shared) {
+        if (s.copy->closed()) {
+          stale = true;
+          return;
+        }
+        s.copy->push(*ev);
+        return;
+      }
+      if (s.shared->closed()) {
+        stale = true;
+        return;
+      }
+      if (!shared) {
+        shared = std::make_shared<const EventT>(std::move(local));
+        ev = shared.get();
+      }
+      s.shared->push(shared);
+    };
+
+    for (auto& s : snap->unfiltered) {
+      deliver(s);
+    }
+    for (auto& idx : snap->indexes) {
+      auto it = idx.by_key.find(idx.key_of(ev->payload));
+      if (it == idx.by_key.end()) continue;
+      for (auto& s : it->second) {
+        deliver(s);
+      }
+    }
+
+    if (stale) prune();
+  }
+
+  // Drops subscribers whose channel is closed, releasing the broker's
+  // reference to it. publish() calls this itself; it is public for brokers
+  // that rarely publish.
+  void prune() {
+    remove([](const Sub& s) { return s.dead(); });
+  }
+
+  std::size_t subscriber_count() const { return snapshot_.load()->subs.size(); }
+
+  std::vector<SubscriberStats> stats() const {
+    auto snap = snapshot_.load();
+    std::vector<SubscriberStats> out;
+    out.reserve(snap->subs.size());
+    for (auto& s : snap->subs) {
+      SubscriberStats st{s.id, s.filter.key, 0, {}};
+      if (s.copy) {
+        st.capacity = s.copy->capacity();
+        st.channel = s.copy->stats();
+      } else {
+        st.capacity = s.shared->capacity();
+        st.channel = s.shared->stats();
+      }
+      out.push_back(std::move(st));
+    }
+    return out;
+  }
+
+ private:
+  // Exactly one of the two channels is set; is_shared says which.
+  struct Sub {
+    std::size_t id = 0;
+    std::shared_ptr<ChannelT> copy;
+    std::shared_ptr<SharedChannelT> shared;
+    Filter<T> filter;
+    bool is_shared = false;
+
+    bool dead() const { return is_shared ? shared->closed() : copy->closed(); }
+
+    void close() const {
+      if (copy) copy->close();
+      if (shared) shared->close();
+    }
+  };
+
+  struct Index {
+    typename Filter<T>::KeyFn key_of;
+    std::unordered_map<std::string, std::vector<Sub>> by_key;
+  };
+
+  // subs is the source of truth; unfiltered/indexes are derived routing tables.
+  struct Snapshot {
+    std::vector<Sub> subs;
+    std::vector<Sub> unfiltered;
+    std::vector<Index> indexes;
+  };
+
+  static std::shared_ptr<const Snapshot> build(std::vector<Sub> subs) {
+    auto next = std::make_shared<Snapshot>();
+    for (auto& s : subs) {
+      if (!s.filter.key_of) {
+        next->unfiltered.push_back(s);
+        continue;
+      }
+      auto idx = std::find_if(next->indexes.begin(), next->indexes.end(),
+                              [&](const Index& i) { return i.key_of == s.filter.key_of; });
+      if (idx == next->indexes.end()) {
+        idx = next->indexes.insert(next->indexes.end(), Index{s.filter.key_of, {}});
+      }
+      idx->by_key[s.filter.key].push_back(s);
+    }
+    next->subs = std::move(subs);
+    return next;
+  }
+
+  void add(Sub sub) {
     {
       std::lock_guard<std::mutex> lk(mu_);
-      if (shutdown_) return;
-      subs_copy = subs_;
+      if (!shutdown_) {
+        sub.id = next_id_++;
+        auto subs = snapshot_.load()->subs;
+        subs.push_back(std::move(sub));
+        snapshot_.store(build(std::move(subs)));
+        return;
+      }
     }
-    EventT ev{type, std::move(payload)};
-    for (auto& [_, ch] : subs_copy) {
-      ch->push(ev);
+    sub.close();
+  }
+
+  template <typename Pred>
+  void remove(Pred pred) {
+    std::lock_guard<std::mutex> lk(mu_);
+    auto cur = snapshot_.load();
+    std::vector<Sub> subs;
+    subs.reserve(cur->subs.size());
+    for (auto& s : cur->subs) {
+      if (!pred(s)) subs.push_back(s);
     }
+    if (subs.size() == cur->subs.size()) return;
+    snapshot_.store(build(std::move(subs)));
   }
 
- private:
   std::mutex mu_;
   bool shutdown_ = false;
   std::size_t next_id_ = 1;
-  std::unordered_map<std::size_t, std::shared_ptr<ChannelT>> subs_;
+  std::atomic<std::shared_ptr<const Snapshot>> snapshot_{std::make_shared<const Snapshot>()};
 };
 
 }  // namespace pubsub
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <optional>
+
+namespace pubsub {
+
+// Bounded multi-producer/multi-consumer queue (Vyukov's sequence-per-slot design).
+// try_push/try_pop never block and never take a lock; callers decide how to wait.
+template <typename T>
+class RingBuffer {
+ public:
+  // Capacity is rounded up to the next power of two (minimum 2).
+  explicit RingBuffer(std::size_t capacity) {
+    std::size_t cap = 2;
+    while (cap < capacity) cap <<= 1;
+    mask_ = cap - 1;
+    slots_ = std::make_unique<Slot[]>(cap);
+    for (std::size_t i = 0; i < cap; i++) {
+      slots_[i].seq.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  RingBuffer(const RingBuffer&) = delete;
+  RingBuffer& operator=(const RingBuffer&) = delete;
+
+  // Moves from v only on success; v is untouched when the buffer is full.
+  bool try_push(T& v) {
+    std::size_t pos = tail_.load(std::memory_order_relaxed);
+    while (true) {
+      Slot& s = slots_[pos & mask_];
+      std::size_t seq = s.seq.load(std::memory_order_acquire);
+      auto diff = (std::ptrdiff_t)seq - (std::ptrdiff_t)pos;
+      if (diff == 0) {
+        if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          s.value.emplace(std::move(v));
+          s.seq.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;  // full
+      } else {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  std::optional<T> try_pop() {
+    std::size_t pos = head_.load(std::memory_order_relaxed);
+    while (true) {
+      Slot& s = slots_[pos & mask_];
+      std::size_t seq = s.seq.load(std::memory_order_acquire);
+      auto diff = (std::ptrdiff_t)seq - (std::ptrdiff_t)(pos + 1);
+      if (diff == 0) {
+        if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          std::optional<T> out(std::move(*s.value));
+          s.value.reset();
+          s.seq.store(pos + mask_ + 1, std::memory_order_release);
+          return out;
+        }
+      } else if (diff < 0) {
+        return std::nullopt;  // empty
+      } else {
+        pos = head_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  std::size_t capacity() const { return mask_ + 1; }
+
+  // Racy by nature; only meant for diagnostics.
+  std::size_t size_approx() const {
+    auto tail = tail_.load(std::memory_order_relaxed);
+    auto head = head_.load(std::memory_order_relaxed);
+    return tail > head ? tail - head : 0;
+  }
+
+ private:
+  struct Slot {
+    std::atomic<std::size_t> seq{0};
+    std::optional<T> value;
+  };
+
+  std::unique_ptr<Slot[]> slots_;
+  std::size_t mask_ = 0;
+  alignas(64) std::atomic<std::size_t> head_{0};
+  alignas(64) std::atomic<std::size_t> tail_{0};
+};
+
+}  // namespace pubsub
@@ -1,24 +1,19 @@
 #include "session/session.hpp"
 
 #include <chrono>
-#include <random>
 #include <stdexcept>
 
 #include <sqlite3.h>
 
+#include "db/archive.hpp"
+#include "db/id.hpp"
+
 namespace session {
 
-static std::string random_id() {
-  static thread_local std::mt19937_64 rng{std::random_device{}()};
-  std::uniform_int_distribution<std::uint64_t> dist;
-  auto a = dist(rng);
-  auto b = dist(rng);
-  char buf[33];
-  std::snprintf(buf, sizeof(buf), "%016llx%016llx", (unsigned long long)a, (unsigned long long)b);
-  return std::string(buf);
-}
+Service::Service(db::Pool& pool) : pool_(pool) {}
 
-Service::Service(db::Db& db) : db_(db) {}
+// Queued async calls capture `this`.
+Service::~Service() { pool_.executor().drain(); }
 
 Session Service::create(std::string title) {
   auto now = std::chrono::duration_cast<std::chrono::seconds>(
@@ -26,94 +21,134 @@ Session Service::create(std::string title) {
                  .count();
 
   Session s;
-  s.id = random_id();
+  s.id = db::new_id();
   s.title = std::move(title);
   s.created_at = (std::int64_t)now;
 
-  sqlite3_stmt* stmt = nullptr;
   const char* sql = "INSERT INTO sessions(id, title, created_at) VALUES(?, ?, ?);";
-  if (sqlite3_prepare_v2(db_.get(), sql, -1, &stmt, nullptr) != SQLITE_OK) {
-    throw std::runtime_error(sqlite3_errmsg(db_.get()));
-  }
+  auto writer = pool_.writer();
+  auto& db = *writer;
+  auto stmt = db.prepare(sql);
 
   sqlite3_bind_text(stmt, 1, s.id.c_str(), -1, SQLITE_TRANSIENT);
   sqlite3_bind_text(stmt, 2, s.title.c_str(), -1, SQLITE_TRANSIENT);
   sqlite3_bind_int64(stmt, 3, s.created_at);
 
   int rc = sqlite3_step(stmt);
-  sqlite3_finalize(stmt);
 
   if (rc != SQLITE_DONE) {
-    throw std::runtime_error(sqlite3_errmsg(db_.get()));
+    throw std::runtime_error(sqlite3_errmsg(db.get()));
   }
 
   return s;
 }
 
-std::vector<Session> Service::list() {
-  std::vector<Session> out;
-
-  sqlite3_stmt* stmt = nullptr;
-  const char* sql = "SELECT id, title, created_at FROM sessions ORDER BY created_at DESC;";
-  if (sqlite3_prepare_v2(db_.get(), sql, -1, &stmt, nullptr) != SQLITE_OK) {
-    throw std::runtime_error(sqlite3_errmsg(db_.get()));
-  }
+// Reads id, title, created_at, message_count, last_message_at, preview.
+static Session read_session(sqlite3_stmt* stmt) {
+  Session s;
+  s.id = (const char*)sqlite3_column_text(stmt, 0);
+  s.title = (const char*)sqlite3_column_text(stmt, 1);
+  s.created_at = sqlite3_column_int64(stmt, 2);
+  s.message_count = sqlite3_column_int64(stmt, 3);
+  s.last_message_at = sqlite3_column_int64(stmt, 4);
+  if (auto preview = (const char*)sqlite3_column_text(stmt, 5)) s.preview = preview;
+  return s;
+}
 
+static std::vector<Session> read_sessions(db::Db& db, sqlite3_stmt* stmt) {
+  std::vector<Session> out;
   while (true) {
     int rc = sqlite3_step(stmt);
     if (rc == SQLITE_ROW) {
-      Session s;
-      s.id = (const char*)sqlite3_column_text(stmt, 0);
-      s.title = (const char*)sqlite3_column_text(stmt, 1);
-      s.created_at = sqlite3_column_int64(stmt, 2);
-      out.push_back(std::move(s));
+      out.push_back(read_session(stmt));
       continue;
     }
     if (rc == SQLITE_DONE) break;
-    sqlite3_finalize(stmt);
-    throw std::runtime_error(sqlite3_errmsg(db_.get()));
+    throw std::runtime_error(sqlite3_errmsg(db.get()));
   }
-
-  sqlite3_finalize(stmt);
   return out;
 }
 
+std::vector<Session> Service::list() {
+  const char* sql =
+      "SELECT id, title, created_at, message_count, last_message_at, preview FROM sessions "
+      "ORDER BY id DESC;";
+  auto db = pool_.reader();
+  auto stmt = db->prepare(sql);
+  return read_sessions(*db, stmt);
+}
+
+std::vector<Session> Service::list_recent(std::size_t limit) {
+  if (limit == 0) return {};
+
+  // Walks idx_sessions_last_activity backwards; the ORDER BY must match the
+  // indexed expression for SQLite to skip the sort.
+  const char* sql =
+      "SELECT id, title, created_at, message_count, last_message_at, preview FROM sessions "
+      "ORDER BY coalesce(last_message_at, created_at) DESC, id DESC LIMIT ?;";
+  auto db = pool_.reader();
+  auto stmt = db->prepare(sql);
+  sqlite3_bind_int64(stmt, 1, (sqlite3_int64)limit);
+  return read_sessions(*db, stmt);
+}
+
 Session Service::get(const std::string& id) {
-  sqlite3_stmt* stmt = nullptr;
-  const char* sql = "SELECT id, title, created_at FROM sessions WHERE id = ? LIMIT 1;";
-  if (sqlite3_prepare_v2(db_.get(), sql, -1, &stmt, nullptr) != SQLITE_OK) {
-    throw std::runtime_error(sqlite3_errmsg(db_.get()));
+  {
+    const char* sql =
+        "SELECT id, title, created_at, message_count, last_message_at, preview FROM sessions "
+        "WHERE id = ? LIMIT 1;";
+    auto db = pool_.reader();
+    auto stmt = db->prepare(sql);
+    sqlite3_bind_text(stmt, 1, id.c_str(), -1, SQLITE_TRANSIENT);
+
+    int rc = sqlite3_step(stmt);
+    if (rc == SQLITE_ROW) return read_session(stmt);
+    if (rc != SQLITE_DONE) throw std::runtime_error(sqlite3_errmsg(db->get()));
   }
-  sqlite3_bind_text(stmt, 1, id.c_str(), -1, SQLITE_TRANSIENT);
 
-  int rc = sqlite3_step(stmt);
-  if (rc != SQLITE_ROW) {
-    sqlite3_finalize(stmt);
+  return get_archived(id);
+}
+
+// Only opens the one archive file archived_sessions points at.
+Session Service::get_archived(const std::string& id) {
+  std::string period;
+  {
+    auto db = pool_.reader();
+    period = db::archived_period(*db, id);
+  }
+  if (period.empty() || pool_.data_dir().empty()) {
     throw std::runtime_error("session not found");
   }
 
-  Session s;
-  s.id = (const char*)sqlite3_column_text(stmt, 0);
-  s.title = (const char*)sqlite3_column_text(stmt, 1);
-  s.created_at = sqlite3_column_int64(stmt, 2);
+  auto archive = db::connect_archive(db::archive_path(pool_.data_dir(), period));
+  const char* sql =
+      "SELECT id, title, created_at, message_count, last_message_at, preview FROM sessions "
+      "WHERE id = ? LIMIT 1;";
+  auto stmt = archive.prepare(sql);
+  sqlite3_bind_text(stmt, 1, id.c_str(), -1, SQLITE_TRANSIENT);
+
+  int rc = sqlite3_step(stmt);
+  if (rc == SQLITE_DONE) throw std::runtime_error("session not found");
+  if (rc != SQLITE_ROW) throw std::runtime_error(sqlite3_errmsg(archive.get()));
 
-  sqlite3_finalize(stmt);
+  Session s = read_session(stmt);
+  s.archived = true;
   return s;
 }
 
 void Service::update_title(const std::string& id, const std::string& title) {
-  sqlite3_stmt* stmt = nullptr;
   const char* sql = "UPDATE sessions SET title = ? WHERE id = ?;";
-  if (sqlite3_prepare_v2(db_.get(), sql, -1, &stmt, nullptr) != SQLITE_OK) {
-    throw std::runtime_error(sqlite3_errmsg(db_.get()));
-  }
-  sqlite3_bind_text(stmt, 1, title.c_str(), -1, SQLITE_TRANSIENT);
-  sqlite3_bind_text(stmt, 2, id.c_str(), -1, SQLITE_TRANSIENT);
+  {
+    auto writer = pool_.writer();
+    auto& db = *writer;
+    auto stmt = db.prepare(sql);
+    sqlite3_bind_text(stmt, 1, title.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 2, id.c_str(), -1, SQLITE_TRANSIENT);
 
-  int rc = sqlite3_step(stmt);
-  sqlite3_finalize(stmt);
-  if (rc != SQLITE_DONE) {
-    throw std::runtime_error(sqlite3_errmsg(db_.get()));
+    int rc = sqlite3_step(stmt);
+    if (rc != SQLITE_DONE) {
+      throw std::runtime_error(sqlite3_errmsg(db.get()));
+    }
   }
 
   // Publish update event
@@ -121,7 +156,55 @@ void Service::update_title(const std::string& id, const std::string& title) {
   broker_.publish(pubsub::EventType::Updated, updated);
 }
 
-std::shared_ptr<pubsub::Channel<pubsub::Event<Session>>> Service::subscribe() {
+std::vector<std::string> Service::archive_idle(std::chrono::seconds idle_for) {
+  if (pool_.data_dir().empty()) throw std::runtime_error("archiving needs a data directory");
+
+  auto now = std::chrono::duration_cast<std::chrono::seconds>(
+                 std::chrono::system_clock::now().time_since_epoch())
+                 .count();
+  auto moved = db::archive_sessions(*pool_.writer(), pool_.data_dir(),
+                                    (std::int64_t)now - (std::int64_t)idle_for.count());
+
+  for (const auto& id : moved) {
+    Session s;
+    s.id = id;
+    broker_.publish(pubsub::EventType::Deleted, s);
+  }
+  return moved;
+}
+
+bool Service::restore(const std::string& id) {
+  if (pool_.data_dir().empty()) return false;
+  if (!db::restore_session(*pool_.writer(), pool_.data_dir(), id)) return false;
+
+  broker_.publish(pubsub::EventType::Created, get(id));
+  return true;
+}
+
+std::future<Session> Service::async_create(std::string title) {
+  return pool_.executor().submit([this, title = std::move(title)]() mutable {
+    return create(std::move(title));
+  });
+}
+
+std::future<std::vector<Session>> Service::async_list() {
+  return pool_.executor().submit([this] { return list(); });
+}
+
+std::future<std::vector<Session>> Service::async_list_recent(std::size_t limit) {
+  return pool_.executor().submit([this, limit] { return list_recent(limit); });
+}
+
+std::future<Session> Service::async_get(std::string id) {
+  return pool_.executor().submit([this, id = std::move(id)] { return get(id); });
+}
+
+std::future<void> Service::async_update_title(std::string id, std::string title) {
+  return pool_.executor().submit(
+      [this, id = std::move(id), title = std::move(title)] { update_title(id, title); });
+}
+
+pubsub::EventSubscription<Session> Service::subscribe() {
   return broker_.subscribe();
 }
 
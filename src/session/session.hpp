@@ -1,10 +1,12 @@
 #pragma once
 
+#include <chrono>
 #include <cstdint>
+#include <future>
 #include <string>
 #include <vector>
 
-#include "db/db.hpp"
+#include "db/pool.hpp"
 #include "pubsub/broker.hpp"
 
 namespace session {
@@ -13,21 +15,58 @@ struct Session {
   std::string id;
   std::string title;
   std::int64_t created_at = 0;
+  // Maintained by triggers on messages (see migrations/0005).
+  std::int64_t message_count = 0;
+  // created_at of the newest message; 0 if the session has none.
+  std::int64_t last_message_at = 0;
+  // First 200 characters of the newest message.
+  std::string preview;
+  // Read from the cold archive (see archive_idle()); restore() before use.
+  bool archived = false;
 };
 
 class Service {
  public:
-  explicit Service(db::Db& db);
+  explicit Service(db::Pool& pool);
+  ~Service();
+
+  Service(const Service&) = delete;
+  Service& operator=(const Service&) = delete;
 
   Session create(std::string title);
   std::vector<Session> list();
+  // The `limit` most recently active sessions (by last message, or creation
+  // if empty), newest first. One indexed read, no per-session queries.
+  std::vector<Session> list_recent(std::size_t limit);
+  // Falls back to the archive file holding `id` if it was archived.
   Session get(const std::string& id);
   void update_title(const std::string& id, const std::string& title);
 
-  std::shared_ptr<pubsub::Channel<pubsub::Event<Session>>> subscribe();
+  // Moves sessions with no activity for `idle_for` out of openvim.db into
+  // per-month archive files and publishes Deleted for each (only id set).
+  // Returns their ids; pass each to message::Service::evict() so its cache
+  // stops serving their rows.
+  std::vector<std::string> archive_idle(std::chrono::seconds idle_for);
+
+  // Brings an archived session and its messages back into openvim.db and
+  // publishes Created. Returns false if it wasn't archived. As with
+  // archive_idle(), evict `id` from message::Service afterwards.
+  bool restore(const std::string& id);
+
+  // The same operations run on the pool's db::Executor, for callers (the UI)
+  // that must not block on SQLite. Errors arrive through the future.
+  std::future<Session> async_create(std::string title);
+  std::future<std::vector<Session>> async_list();
+  std::future<std::vector<Session>> async_list_recent(std::size_t limit);
+  std::future<Session> async_get(std::string id);
+  std::future<void> async_update_title(std::string id, std::string title);
+
+  pubsub::EventSubscription<Session> subscribe();
 
  private:
-  db::Db& db_;
+  Session get_archived(const std::string& id);
+
+  db::Pool& pool_;
   pubsub::Broker<Session> broker_;
 };
 
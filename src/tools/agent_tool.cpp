@@ -12,7 +12,7 @@ std::string AgentTool::description() const {
   return "Launch a sub-agent for tasks";
 }
 
-ToolResult AgentTool::execute(const std::vector<std::string>& args) {
+ToolResult AgentTool::execute(const std::vector<std::string>& args, const CancelToken& /*cancel*/) {
   if (args.empty()) {
     return {"No prompt provided", false};
   }
@@ -10,7 +10,7 @@ class AgentTool : public BaseTool {
 
   std::string name() const override;
   std::string description() const override;
-  ToolResult execute(const std::vector<std::string>& args) override;
+  ToolResult execute(const std::vector<std::string>& args, const CancelToken& cancel) override;
 
  private:
   std::string working_dir_;
@@ -1,11 +1,19 @@
 #include "tools/bash_tool.hpp"
 
 #include <array>
-#include <cstdio>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
 #include <iostream>
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 namespace tools {
 
@@ -19,7 +27,32 @@ std::string BashTool::description() const {
   return "Execute bash commands";
 }
 
-ToolResult BashTool::execute(const std::vector<std::string>& args) {
+// Starts `sh -c cmd` in its own process group with stdout on a pipe, so a
+// cancel can kill it and anything it started. Returns the read end of the
+// pipe, or -1.
+static int spawn(const std::string& cmd, pid_t& pid) {
+  int fds[2];
+  if (pipe2(fds, O_CLOEXEC) != 0) return -1;
+
+  pid = fork();
+  if (pid < 0) {
+    close(fds[0]);
+    close(fds[1]);
+    return -1;
+  }
+  if (pid == 0) {
+    setpgid(0, 0);
+    dup2(fds[1], STDOUT_FILENO);
+    execl("/bin/sh", "sh", "-c", cmd.c_str(), (char*)nullptr);
+    _exit(127);
+  }
+  // Also from the parent, so the group exists before any kill() below.
+  setpgid(pid, pid);
+  close(fds[1]);
+  return fds[0];
+}
+
+ToolResult BashTool::execute(const std::vector<std::string>& args, const CancelToken& cancel) {
   if (args.empty()) {
     return {"No command provided", false};
   }
@@ -29,16 +62,44 @@ ToolResult BashTool::execute(const std::vector<std::string>& args) {
     cmd += " " + args[i];
   }
 
-  std::array<char, 128> buffer;
-  std::string result;
-  std::unique_ptr<FILE, decltype(&pclose)> pipe(popen(cmd.c_str(), "r"), pclose);
-  if (!pipe) {
+  pid_t pid = -1;
+  int out = spawn(cmd, pid);
+  if (out < 0) {
     return {"Failed to run command", false};
   }
-  while (fgets(buffer.data(), buffer.size(), pipe.get()) != nullptr) {
-    result += buffer.data();
+
+  // The process isn't reaped until after this is unregistered, so its pid
+  // can't have been reused when the callback runs.
+  std::string result;
+  {
+    auto kill_on_cancel = cancel.on_cancel([pid] { kill(-pid, SIGKILL); });
+
+    std::array<char, 4096> buffer;
+    while (true) {
+      ssize_t n = read(out, buffer.data(), buffer.size());
+      if (n > 0) {
+        result.append(buffer.data(), (size_t)n);
+      } else if (n == 0 || errno != EINTR) {
+        break;
+      }
+    }
+    close(out);
+
+    // stdout is closed but the command may still be running (e.g. it
+    // redirected its output); wait for it while still cancellable. WNOWAIT
+    // leaves it a zombie so its pid stays reserved.
+    using namespace std::chrono_literals;
+    siginfo_t info{};
+    while (waitid(P_PID, (id_t)pid, &info, WEXITED | WNOHANG | WNOWAIT) == 0 && info.si_pid == 0) {
+      std::this_thread::sleep_for(10ms);
+    }
+  }
+  waitpid(pid, nullptr, 0);
+
+  if (cancel.cancelled()) {
+    return {"Command cancelled", false};
   }
   return {result, true};
 }
 
-}  // namespace tools
\ No newline at end of file
+}  // namespace tools
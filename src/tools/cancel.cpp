@@ -0,0 +1,34 @@
+#include "tools/cancel.hpp"
+
+#include <utility>
+
+namespace tools {
+
+void CancelToken::cancel() {
+  // Callbacks run under the lock so an unregistering Registration waits for
+  // a callback that is still running.
+  std::lock_guard<std::mutex> lk(mu_);
+  if (cancelled_.exchange(true, std::memory_order_acq_rel)) return;
+  for (auto& [id, fn] : callbacks_) fn();
+  callbacks_.clear();
+}
+
+CancelToken::Registration CancelToken::on_cancel(std::function<void()> fn) const {
+  std::unique_lock<std::mutex> lk(mu_);
+  if (cancelled()) {
+    lk.unlock();
+    fn();
+    return Registration(nullptr, 0);
+  }
+  auto id = next_id_++;
+  callbacks_.emplace(id, std::move(fn));
+  return Registration(this, id);
+}
+
+CancelToken::Registration::~Registration() {
+  if (!token_) return;
+  std::lock_guard<std::mutex> lk(token_->mu_);
+  token_->callbacks_.erase(id_);
+}
+
+}  // namespace tools
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+
+namespace tools {
+
+// Thrown by code that noticed its token was cancelled and gave up.
+class Cancelled : public std::runtime_error {
+ public:
+  Cancelled() : std::runtime_error("cancelled") {}
+};
+
+// Set once to ask a running turn, and whatever it is blocked on, to stop.
+// Polling cancelled() is enough for loops; for blocking calls register a
+// callback that unblocks them (closing a socket, killing a process).
+class CancelToken {
+ public:
+  // Unregisters its callback when destroyed. If the callback is running on
+  // another thread at that moment, waits for it to return, so whatever it
+  // refers to may be destroyed right after.
+  class Registration {
+   public:
+    Registration(Registration&& other) noexcept : token_(other.token_), id_(other.id_) {
+      other.token_ = nullptr;
+    }
+    Registration& operator=(Registration&&) = delete;
+    ~Registration();
+
+   private:
+    friend class CancelToken;
+    Registration(const CancelToken* token, std::uint64_t id) : token_(token), id_(id) {}
+    const CancelToken* token_;
+    std::uint64_t id_;
+  };
+
+  CancelToken() = default;
+  CancelToken(const CancelToken&) = delete;
+  CancelToken& operator=(const CancelToken&) = delete;
+
+  bool cancelled() const { return cancelled_.load(std::memory_order_acquire); }
+
+  void throw_if_cancelled() const {
+    if (cancelled()) throw Cancelled();
+  }
+
+  // Runs the registered callbacks on the calling thread. Later calls do
+  // nothing.
+  void cancel();
+
+  // fn runs once on cancel(), or right away if that already happened. It
+  // must not register or unregister callbacks itself.
+  Registration on_cancel(std::function<void()> fn) const;
+
+ private:
+  std::atomic<bool> cancelled_{false};
+  mutable std::mutex mu_;
+  mutable std::map<std::uint64_t, std::function<void()>> callbacks_;
+  mutable std::uint64_t next_id_ = 0;
+};
+
+}  // namespace tools
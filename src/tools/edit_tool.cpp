@@ -9,7 +9,7 @@ namespace tools {
 
 EditTool::EditTool(const std::string& working_dir) : working_dir_(working_dir) {}
 
-ToolResult EditTool::execute(const std::vector<std::string>& args) {
+ToolResult EditTool::execute(const std::vector<std::string>& args, const CancelToken& /*cancel*/) {
   if (args.size() < 3) {
     return ToolResult{"file_path, old_string, and new_string are required", true};
   }
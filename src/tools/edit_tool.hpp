@@ -16,7 +16,7 @@ class EditTool : public BaseTool {
     return "Edit files by replacing text. Finds and replaces exact string matches in files.";
   }
   
-  ToolResult execute(const std::vector<std::string>& args) override;
+  ToolResult execute(const std::vector<std::string>& args, const CancelToken& cancel) override;
 
  private:
   std::string working_dir_;
@@ -7,7 +7,7 @@ namespace tools {
 
 FileTool::FileTool(const std::string& working_dir) : working_dir_(working_dir) {}
 
-ToolResult FileTool::execute(const std::vector<std::string>& args) {
+ToolResult FileTool::execute(const std::vector<std::string>& args, const CancelToken& /*cancel*/) {
   if (args.empty()) {
     return ToolResult{"operation is required (read, exists, size, delete)", true};
   }
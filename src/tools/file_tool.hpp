@@ -16,7 +16,7 @@ class FileTool : public BaseTool {
     return "Basic file operations: check existence, get size, delete files.";
   }
   
-  ToolResult execute(const std::vector<std::string>& args) override;
+  ToolResult execute(const std::vector<std::string>& args, const CancelToken& cancel) override;
 
  private:
   std::string working_dir_;
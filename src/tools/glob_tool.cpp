@@ -8,7 +8,7 @@ namespace tools {
 
 GlobTool::GlobTool(const std::string& working_dir) : working_dir_(working_dir) {}
 
-ToolResult GlobTool::execute(const std::vector<std::string>& args) {
+ToolResult GlobTool::execute(const std::vector<std::string>& args, const CancelToken& cancel) {
   if (args.size() < 1) {
     return ToolResult{"pattern is required", true};
   }
@@ -21,7 +21,7 @@ ToolResult GlobTool::execute(const std::vector<std::string>& args) {
   }
   
   try {
-    auto matches = glob_files(pattern, path);
+    auto matches = glob_files(pattern, path, cancel);
     
     if (matches.empty()) {
       return ToolResult{"No files found matching pattern: " + pattern};
@@ -38,7 +38,8 @@ ToolResult GlobTool::execute(const std::vector<std::string>& args) {
   }
 }
 
-std::vector<std::string> GlobTool::glob_files(const std::string& pattern, const std::string& search_path, int limit) {
+std::vector<std::string> GlobTool::glob_files(const std::string& pattern, const std::string& search_path,
+                                              const CancelToken& cancel, int limit) {
   std::vector<std::string> results;
   
   try {
@@ -48,7 +49,7 @@ std::vector<std::string> GlobTool::glob_files(const std::string& pattern, const
     }
     
     for (const auto& entry : std::filesystem::recursive_directory_iterator(search_dir)) {
-      if (results.size() >= limit) break;
+      if (results.size() >= limit || cancel.cancelled()) break;
       
       std::string filename = entry.path().filename().string();
       if (matches_pattern(filename, pattern)) {
@@ -17,12 +17,13 @@ class GlobTool : public BaseTool {
     return "Find files by name patterns (glob). Returns matching file paths sorted by modification time.";
   }
   
-  ToolResult execute(const std::vector<std::string>& args) override;
+  ToolResult execute(const std::vector<std::string>& args, const CancelToken& cancel) override;
 
  private:
   std::string working_dir_;
   
-  std::vector<std::string> glob_files(const std::string& pattern, const std::string& search_path, int limit = 1000);
+  std::vector<std::string> glob_files(const std::string& pattern, const std::string& search_path, const CancelToken& cancel,
+                                      int limit = 1000);
   bool matches_pattern(const std::string& filename, const std::string& pattern);
 };
 
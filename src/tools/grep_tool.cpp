@@ -10,7 +10,7 @@ namespace tools {
 
 GrepTool::GrepTool(const std::string& working_dir) : working_dir_(working_dir) {}
 
-ToolResult GrepTool::execute(const std::vector<std::string>& args) {
+ToolResult GrepTool::execute(const std::vector<std::string>& args, const CancelToken& cancel) {
   if (args.size() < 1) {
     return ToolResult{"pattern is required", true};
   }
@@ -28,7 +28,7 @@ ToolResult GrepTool::execute(const std::vector<std::string>& args) {
   
   try {
     std::regex regex_pattern(pattern);
-    auto matches = grep_files(pattern, path, include);
+    auto matches = grep_files(pattern, path, cancel, include);
     
     if (matches.empty()) {
       return ToolResult{"No files found containing pattern: " + pattern};
@@ -47,7 +47,8 @@ ToolResult GrepTool::execute(const std::vector<std::string>& args) {
   }
 }
 
-std::vector<std::string> GrepTool::grep_files(const std::string& pattern, const std::string& path, const std::string& include) {
+std::vector<std::string> GrepTool::grep_files(const std::string& pattern, const std::string& path, const CancelToken& cancel,
+                                              const std::string& include) {
   std::vector<std::pair<std::string, std::filesystem::file_time_type>> matches;
   
   try {
@@ -69,6 +70,7 @@ std::vector<std::string> GrepTool::grep_files(const std::string& pattern, const
     }
     
     for (const auto& entry : std::filesystem::recursive_directory_iterator(search_path)) {
+      if (cancel.cancelled()) break;
       if (!entry.is_regular_file()) continue;
       
       std::string file_path = entry.path().string();
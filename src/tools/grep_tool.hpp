@@ -17,12 +17,13 @@ class GrepTool : public BaseTool {
     return "Search file contents using regular expressions. Finds files containing specific patterns.";
   }
   
-  ToolResult execute(const std::vector<std::string>& args) override;
+  ToolResult execute(const std::vector<std::string>& args, const CancelToken& cancel) override;
 
  private:
   std::string working_dir_;
   
-  std::vector<std::string> grep_files(const std::string& pattern, const std::string& path, const std::string& include = "");
+  std::vector<std::string> grep_files(const std::string& pattern, const std::string& path, const CancelToken& cancel,
+                                      const std::string& include = "");
   bool file_contains_pattern(const std::string& file_path, const std::regex& pattern);
 };
 
@@ -8,7 +8,7 @@ namespace tools {
 
 LsTool::LsTool(const std::string& working_dir) : working_dir_(working_dir) {}
 
-ToolResult LsTool::execute(const std::vector<std::string>& args) {
+ToolResult LsTool::execute(const std::vector<std::string>& args, const CancelToken& /*cancel*/) {
   if (args.empty()) {
     return ToolResult{"path is required", true};
   }
@@ -16,7 +16,7 @@ class LsTool : public BaseTool {
     return "List files and directories in a given path. Shows hierarchical view of directory contents.";
   }
   
-  ToolResult execute(const std::vector<std::string>& args) override;
+  ToolResult execute(const std::vector<std::string>& args, const CancelToken& cancel) override;
 
  private:
   std::string working_dir_;
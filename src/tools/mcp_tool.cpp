@@ -64,7 +64,7 @@ std::string MCPTool::description() const {
   return "MCP server providing various tools";
 }
 
-ToolResult MCPTool::execute(const std::vector<std::string>& args) {
+ToolResult MCPTool::execute(const std::vector<std::string>& args, const CancelToken& /*cancel*/) {
   ToolResult result;
   
   if (args.empty()) {
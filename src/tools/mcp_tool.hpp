@@ -22,7 +22,7 @@ class MCPTool : public BaseTool {
 
   std::string name() const override;
   std::string description() const override;
-  ToolResult execute(const std::vector<std::string>& args) override;
+  ToolResult execute(const std::vector<std::string>& args, const CancelToken& cancel) override;
 
   // Get list of available tools from this MCP server
   std::vector<std::string> available_tools() const;
@@ -3,6 +3,8 @@
 #include <string>
 #include <vector>
 
+#include "tools/cancel.hpp"
+
 namespace tools {
 
 struct ToolResult {
@@ -15,7 +17,9 @@ class BaseTool {
   virtual ~BaseTool() = default;
   virtual std::string name() const = 0;
   virtual std::string description() const = 0;
-  virtual ToolResult execute(const std::vector<std::string>& args) = 0;
+  // Long-running tools should watch cancel and return early once it is set;
+  // the caller discards the result.
+  virtual ToolResult execute(const std::vector<std::string>& args, const CancelToken& cancel) = 0;
 };
 
 }  // namespace tools
\ No newline at end of file
@@ -10,7 +10,7 @@ namespace tools {
 
 ViewTool::ViewTool(const std::string& working_dir) : working_dir_(working_dir) {}
 
-ToolResult ViewTool::execute(const std::vector<std::string>& args) {
+ToolResult ViewTool::execute(const std::vector<std::string>& args, const CancelToken& /*cancel*/) {
   if (args.empty()) {
     return ToolResult{"file_path is required", true};
   }
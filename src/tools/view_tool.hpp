@@ -16,7 +16,7 @@ class ViewTool : public BaseTool {
     return "Read and display file contents with line numbers. Supports offset and limit for large files.";
   }
   
-  ToolResult execute(const std::vector<std::string>& args) override;
+  ToolResult execute(const std::vector<std::string>& args, const CancelToken& cancel) override;
 
  private:
   std::string working_dir_;
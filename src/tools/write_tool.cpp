@@ -9,7 +9,7 @@ namespace tools {
 
 WriteTool::WriteTool(const std::string& working_dir) : working_dir_(working_dir) {}
 
-ToolResult WriteTool::execute(const std::vector<std::string>& args) {
+ToolResult WriteTool::execute(const std::vector<std::string>& args, const CancelToken& /*cancel*/) {
   if (args.size() < 2) {
     return ToolResult{"file_path and content are required", true};
   }
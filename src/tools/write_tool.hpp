@@ -16,7 +16,7 @@ class WriteTool : public BaseTool {
     return "Write content to files. Creates parent directories if needed. Overwrites existing files.";
   }
   
-  ToolResult execute(const std::vector<std::string>& args) override;
+  ToolResult execute(const std::vector<std::string>& args, const CancelToken& cancel) override;
 
  private:
   std::string working_dir_;
@@ -0,0 +1,298 @@
+#include "transfer/transfer.hpp"
+
+#include <filesystem>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sqlite3.h>
+
+#include "db/archive.hpp"
+#include "db/blob.hpp"
+#include "json.hpp"
+
+namespace transfer {
+
+// Writes the sessions `sessions` steps over (id, title, created_at), each
+// followed by its messages read through the same connection.
+static void write_sessions(db::Db& db, sqlite3_stmt* sessions, std::ostream& out, Stats& stats) {
+  const char* messages_sql =
+      "SELECT id, role, content, created_at, blob_hash FROM messages WHERE session_id = ? "
+      "ORDER BY id;";
+
+  while (true) {
+    int rc = sqlite3_step(sessions);
+    if (rc == SQLITE_DONE) break;
+    if (rc != SQLITE_ROW) throw std::runtime_error(sqlite3_errmsg(db.get()));
+
+    std::string session_id = (const char*)sqlite3_column_text(sessions, 0);
+    nlohmann::ordered_json s = {
+        {"type", "session"},
+        {"id", session_id},
+        {"title", (const char*)sqlite3_column_text(sessions, 1)},
+        {"created_at", sqlite3_column_int64(sessions, 2)},
+    };
+    out << s.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace) << '\n';
+    stats.sessions++;
+
+    auto messages = db.prepare(messages_sql);
+    sqlite3_bind_text(messages, 1, session_id.c_str(), -1, SQLITE_TRANSIENT);
+    while (true) {
+      rc = sqlite3_step(messages);
+      if (rc == SQLITE_DONE) break;
+      if (rc != SQLITE_ROW) throw std::runtime_error(sqlite3_errmsg(db.get()));
+
+      std::string content;
+      if (auto hash = (const char*)sqlite3_column_text(messages, 4)) {
+        content = db::read_blob(db, hash);
+      } else {
+        content = (const char*)sqlite3_column_text(messages, 2);
+      }
+
+      nlohmann::ordered_json m = {
+          {"type", "message"},
+          {"id", (const char*)sqlite3_column_text(messages, 0)},
+          {"session_id", session_id},
+          {"role", (const char*)sqlite3_column_text(messages, 1)},
+          {"content", std::move(content)},
+          {"created_at", sqlite3_column_int64(messages, 3)},
+      };
+      out << m.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace) << '\n';
+      stats.messages++;
+    }
+  }
+}
+
+Stats export_jsonl(db::Pool& pool, std::ostream& out) {
+  Stats stats;
+  // Archived session ids by period, as of the hot snapshot.
+  std::map<std::string, std::vector<std::string>> archived;
+  {
+    auto db = pool.reader();
+
+    // One read transaction, so the export is a consistent snapshot even while
+    // the app keeps writing.
+    db->exec("BEGIN;");
+    try {
+      auto sessions = db->prepare("SELECT id, title, created_at FROM sessions ORDER BY id;");
+      write_sessions(*db, sessions, out, stats);
+
+      auto stmt = db->prepare("SELECT period, id FROM archived_sessions ORDER BY period, id;");
+      while (true) {
+        int rc = sqlite3_step(stmt);
+        if (rc == SQLITE_DONE) break;
+        if (rc != SQLITE_ROW) throw std::runtime_error(sqlite3_errmsg(db->get()));
+        archived[(const char*)sqlite3_column_text(stmt, 0)].push_back(
+            (const char*)sqlite3_column_text(stmt, 1));
+      }
+      db->exec("COMMIT;");
+    } catch (...) {
+      db->exec("ROLLBACK;");
+      throw;
+    }
+  }
+
+  // Then each archive file, read-only and one snapshot per file. Only the
+  // sessions archived_sessions names are exported; a file can also hold a
+  // stale copy of a session that was restored.
+  for (const auto& [period, ids] : archived) {
+    auto path = db::archive_path(pool.data_dir(), period);
+    if (!std::filesystem::exists(path)) throw std::runtime_error("archive file missing: " + path);
+    auto archive = db::connect_archive(path);
+    archive.exec("BEGIN;");
+    try {
+      for (const auto& id : ids) {
+        auto sessions =
+            archive.prepare("SELECT id, title, created_at FROM sessions WHERE id = ?;");
+        sqlite3_bind_text(sessions, 1, id.c_str(), -1, SQLITE_TRANSIENT);
+        write_sessions(archive, sessions, out, stats);
+      }
+      archive.exec("COMMIT;");
+    } catch (...) {
+      archive.exec("ROLLBACK;");
+      throw;
+    }
+  }
+
+  out.flush();
+  if (!out) throw std::runtime_error("export: write failed");
+  return stats;
+}
+
+static bool import_session(db::Db& db, const nlohmann::json& j) {
+  auto id = j.at("id").get<std::string>();
+  auto title = j.at("title").get<std::string>();
+
+  const char* sql = "INSERT OR IGNORE INTO sessions(id, title, created_at) VALUES(?, ?, ?);";
+  auto stmt = db.prepare(sql);
+  sqlite3_bind_text(stmt, 1, id.c_str(), -1, SQLITE_TRANSIENT);
+  sqlite3_bind_text(stmt, 2, title.c_str(), -1, SQLITE_TRANSIENT);
+  sqlite3_bind_int64(stmt, 3, j.at("created_at").get<std::int64_t>());
+  if (sqlite3_step(stmt) != SQLITE_DONE) throw std::runtime_error(sqlite3_errmsg(db.get()));
+  return sqlite3_changes(db.get()) > 0;
+}
+
+// Messages are staged in a temp table and moved with one INSERT ... SELECT
+// per batch. FTS5 flushes its pending index at every statement boundary, so
+// per-row INSERTs (with the messages_fts trigger) cost several times more.
+// Returns the message's size, for bounding the batch.
+static std::size_t stage_message(db::Db& db, const nlohmann::json& j, const ImportOptions& opts,
+                                 std::size_t lineno) {
+  auto id = j.at("id").get<std::string>();
+  auto session_id = j.at("session_id").get<std::string>();
+  auto role = j.at("role").get<std::string>();
+  if (role != "user" && role != "assistant") throw std::runtime_error("unknown role: " + role);
+  const auto& content = j.at("content").get_ref<const std::string&>();
+
+  // Same layout message::Service writes: large content goes to the blob store
+  // and the row keeps a preview.
+  std::string_view stored = content;
+  std::string hash;
+  if (opts.blob_threshold > 0 && content.size() >= opts.blob_threshold) {
+    hash = db::put_blob(db, content);
+    stored = message::utf8_prefix(content, opts.preview_bytes);
+  }
+
+  const char* sql =
+      "INSERT INTO temp.import_messages(id, session_id, role, content, created_at, blob_hash, line) "
+      "VALUES(?, ?, ?, ?, ?, ?, ?);";
+  auto stmt = db.prepare(sql);
+  sqlite3_bind_text(stmt, 1, id.c_str(), -1, SQLITE_TRANSIENT);
+  sqlite3_bind_text(stmt, 2, session_id.c_str(), -1, SQLITE_TRANSIENT);
+  sqlite3_bind_text(stmt, 3, role.c_str(), -1, SQLITE_TRANSIENT);
+  sqlite3_bind_text(stmt, 4, stored.data(), (int)stored.size(), SQLITE_TRANSIENT);
+  sqlite3_bind_int64(stmt, 5, j.at("created_at").get<std::int64_t>());
+  if (hash.empty()) {
+    sqlite3_bind_null(stmt, 6);
+  } else {
+    sqlite3_bind_text(stmt, 6, hash.c_str(), -1, SQLITE_TRANSIENT);
+  }
+  sqlite3_bind_int64(stmt, 7, (sqlite3_int64)lineno);
+  if (sqlite3_step(stmt) != SQLITE_DONE) throw std::runtime_error(sqlite3_errmsg(db.get()));
+  return id.size() + session_id.size() + content.size();
+}
+
+// The first staged row that `INSERT OR IGNORE` still rejects (a constraint
+// OR IGNORE doesn't cover, such as a foreign key), retried one row at a time
+// so the error can name its input line. Returns only if every row goes in.
+static void find_rejected(db::Db& db) {
+  auto rows = db.prepare("SELECT rowid, line FROM temp.import_messages ORDER BY rowid;");
+  auto insert = db.prepare(
+      "INSERT OR IGNORE INTO messages(id, session_id, role, content, created_at, blob_hash) "
+      "SELECT id, session_id, role, content, created_at, blob_hash FROM temp.import_messages "
+      "WHERE rowid = ?;");
+  while (true) {
+    int rc = sqlite3_step(rows);
+    if (rc == SQLITE_DONE) return;
+    if (rc != SQLITE_ROW) throw std::runtime_error(sqlite3_errmsg(db.get()));
+
+    sqlite3_reset(insert);
+    sqlite3_bind_int64(insert, 1, sqlite3_column_int64(rows, 0));
+    if (sqlite3_step(insert) != SQLITE_DONE) {
+      throw std::runtime_error("import line " + std::to_string(sqlite3_column_int64(rows, 1)) +
+                               ": " + sqlite3_errmsg(db.get()));
+    }
+  }
+}
+
+// Returns how many staged messages were new.
+static std::uint64_t flush_staged(db::Db& db) {
+  try {
+    db.exec(
+        "INSERT OR IGNORE INTO messages(id, session_id, role, content, created_at, blob_hash) "
+        "SELECT id, session_id, role, content, created_at, blob_hash FROM temp.import_messages "
+        "ORDER BY rowid;");
+  } catch (const std::exception&) {
+    // The failed statement was rolled back on its own; the transaction is
+    // still open, so the rows can be replayed to find the culprit.
+    find_rejected(db);
+    throw;
+  }
+  auto n = (std::uint64_t)sqlite3_changes(db.get());
+  db.exec("DELETE FROM temp.import_messages;");
+  return n;
+}
+
+static int pragma_int(db::Db& db, const char* sql) {
+  auto stmt = db.prepare(sql);
+  if (sqlite3_step(stmt) != SQLITE_ROW) throw std::runtime_error(sqlite3_errmsg(db.get()));
+  return sqlite3_column_int(stmt, 0);
+}
+
+Stats import_jsonl(db::Pool& pool, std::istream& in, ImportOptions opts) {
+  Stats stats;
+  // Held for the whole import: its pragmas apply to the connection, not a
+  // transaction.
+  auto writer = pool.writer();
+  auto& db = *writer;
+  if (opts.batch == 0) opts.batch = 1;
+  if (opts.batch_bytes == 0) opts.batch_bytes = 1;
+
+  // Losing the tail of an interrupted import is fine (it can be re-run);
+  // an fsync per batch is not needed for that. The staging table lives in
+  // memory.
+  int synchronous = pragma_int(db, "PRAGMA synchronous;");
+  int temp_store = pragma_int(db, "PRAGMA temp_store;");
+  auto restore = [&] {
+    db.exec(("PRAGMA synchronous = " + std::to_string(synchronous) + ";").c_str());
+    db.exec(("PRAGMA temp_store = " + std::to_string(temp_store) + ";").c_str());
+  };
+  db.exec("PRAGMA synchronous = OFF;");
+  db.exec("PRAGMA temp_store = MEMORY;");
+  db.exec(
+      "CREATE TEMP TABLE IF NOT EXISTS import_messages ("
+      "  id TEXT, session_id TEXT, role TEXT, content TEXT, created_at INTEGER, blob_hash TEXT,"
+      "  line INTEGER);"
+      "DELETE FROM temp.import_messages;");
+
+  std::string line;
+  std::size_t lineno = 0;
+  std::size_t in_batch = 0;
+  std::size_t batch_bytes = 0;
+  try {
+    db.exec("BEGIN IMMEDIATE;");
+    while (std::getline(in, line)) {
+      lineno++;
+      if (!line.empty() && line.back() == '\r') line.pop_back();
+      if (line.find_first_not_of(" \t") == std::string::npos) continue;
+
+      try {
+        auto j = nlohmann::json::parse(line);
+        auto type = j.at("type").get<std::string>();
+        if (type == "session") {
+          if (import_session(db, j)) stats.sessions++;
+        } else if (type == "message") {
+          batch_bytes += stage_message(db, j, opts, lineno);
+        } else {
+          throw std::runtime_error("unknown type: " + type);
+        }
+      } catch (const std::exception& e) {
+        throw std::runtime_error("import line " + std::to_string(lineno) + ": " + e.what());
+      }
+
+      if (++in_batch >= opts.batch || batch_bytes >= opts.batch_bytes) {
+        stats.messages += flush_staged(db);
+        db.exec("COMMIT;");
+        db.exec("BEGIN IMMEDIATE;");
+        in_batch = 0;
+        batch_bytes = 0;
+      }
+    }
+    stats.messages += flush_staged(db);
+    db.exec("COMMIT;");
+
+    // Blobs written for messages that turned out to be duplicates.
+    db.exec("DELETE FROM blobs WHERE refcount <= 0;");
+  } catch (...) {
+    if (!sqlite3_get_autocommit(db.get())) db.exec("ROLLBACK;");
+    db.exec("DELETE FROM temp.import_messages;");
+    restore();
+    throw;
+  }
+
+  restore();
+  return stats;
+}
+
+}  // namespace transfer
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+
+#include "db/pool.hpp"
+#include "message/message.hpp"
+
+namespace transfer {
+
+// Sessions and messages as JSON Lines, one object per line:
+//   {"type":"session","id":...,"title":...,"created_at":...}
+//   {"type":"message","id":...,"session_id":...,"role":"user"|"assistant",
+//    "content":...,"created_at":...}
+// Each session's line precedes its messages. Message content is always the
+// full text; blob storage is a detail of the database it was exported from.
+
+struct Stats {
+  std::uint64_t sessions = 0;
+  std::uint64_t messages = 0;
+};
+
+struct ImportOptions {
+  // A transaction is committed after this many rows or once the content of
+  // the messages in it (staged in memory, see import_jsonl(), or written as
+  // blobs) reaches batch_bytes, whichever comes first.
+  std::size_t batch = 50000;
+  std::size_t batch_bytes = 64 * 1024 * 1024;
+  // Same meaning as in message::Options.
+  std::size_t blob_threshold = message::Options{}.blob_threshold;
+  std::size_t preview_bytes = message::Options{}.preview_bytes;
+};
+
+// Writes every session, each followed by its messages: the hot database's in
+// id order from one snapshot, then the archived ones file by file (see
+// db/archive.hpp). Holds one row (and at most one blob) in memory at a time.
+// Throws std::runtime_error if an archive file the database names is missing.
+Stats export_jsonl(db::Pool& pool, std::ostream& out);
+
+// Reads lines written by export_jsonl() into the database in batched
+// transactions with synchronous = OFF and temp_store = MEMORY, restoring the
+// previous settings after.
+// Rows whose id already exists are skipped, so re-importing is harmless.
+// Throws std::runtime_error naming the line on malformed input or a row the
+// database rejects (e.g. a message whose session is unknown); batches
+// committed before it stay.
+Stats import_jsonl(db::Pool& pool, std::istream& in, ImportOptions opts = {});
+
+}  // namespace transfer
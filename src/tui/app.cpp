@@ -2,6 +2,8 @@
 
 #include <csignal>
 #include <string>
+#include <type_traits>
+#include <vector>
 
 #include <curses.h>
 
@@ -31,12 +33,12 @@ App::App(logging::Logger& logger,
          ReplPage::SessionsProvider sessions_provider,
          ReplPage::MessagesProvider messages_provider,
          ReplPage::SendFn send,
-         std::shared_ptr<pubsub::Channel<pubsub::Event<message::Message>>> message_subscriber,
-         std::shared_ptr<pubsub::Channel<pubsub::Event<session::Session>>> session_subscriber,
-         std::shared_ptr<pubsub::Channel<pubsub::Event<permission::PermissionRequest>>> permission_subscriber)
-    : logger_(logger), message_subscriber_(message_subscriber), session_subscriber_(session_subscriber), permission_subscriber_(permission_subscriber) {
+         pubsub::EventSubscription<message::Message> message_subscriber,
+         pubsub::EventSubscription<session::Session> session_subscriber,
+         pubsub::EventSubscription<permission::PermissionRequest> permission_subscriber)
+    : logger_(logger), message_subscriber_(std::move(message_subscriber)), session_subscriber_(std::move(session_subscriber)), permission_subscriber_(std::move(permission_subscriber)) {
   init_page_ = std::make_unique<InitPage>();
-  repl_page_ = std::make_unique<ReplPage>(std::move(sessions_provider), std::move(messages_provider), std::move(send));
+  repl_page_ = std::make_unique<ReplPage>(logger_, std::move(sessions_provider), std::move(messages_provider), std::move(send));
   logs_page_ = std::make_unique<LogsPage>(logger_);
 }
 
@@ -49,30 +51,31 @@ int App::run() {
   handle_resize();
   render();
 
-  // Thread to listen for message events
-  std::thread message_event_thread([this]() {
+  // Listener threads wake at most every k_poll_interval_ to notice shutdown,
+  // and coalesce whatever burst is queued into a single re-render.
+  auto coalesce = [this](auto& subscriber) {
+    using EventT = typename std::decay_t<decltype(*subscriber)>::value_type;
+    std::vector<EventT> batch;
     while (running_) {
-      auto ev = message_subscriber_->pop();
-      if (ev) {
-        needs_render_ = true;
+      auto ev = subscriber->pop_for(k_poll_interval_);
+      if (!ev) {
+        if (subscriber->closed()) break;
+        continue;
       }
+      batch.clear();
+      subscriber->drain(k_max_batch_, batch);
+      needs_render_ = true;
     }
-  });
+  };
 
-  // Thread to listen for session events
-  std::thread session_event_thread([this]() {
-    while (running_) {
-      auto ev = session_subscriber_->pop();
-      if (ev) {
-        needs_render_ = true;
-      }
-    }
-  });
+  std::thread message_event_thread([&] { coalesce(message_subscriber_); });
+  std::thread session_event_thread([&] { coalesce(session_subscriber_); });
 
   // Thread to listen for permission events
   std::thread permission_event_thread([this]() {
     while (running_) {
-      auto ev = permission_subscriber_->pop();
+      auto ev = permission_subscriber_->pop_for(k_poll_interval_);
+      if (!ev && permission_subscriber_->closed()) break;
       if (ev) {
         // Create permission dialog
         std::string content = "Tool: " + ev->payload.tool_name + "\n" +
@@ -85,7 +88,13 @@ int App::run() {
   });
 
   while (running_) {
-    if (g_resize || needs_render_.exchange(false)) {
+    // Events only mark the REPL's lists stale; the refetch runs on the DB
+    // executor and is drawn once poll() sees it finish.
+    bool dirty = needs_render_.exchange(false);
+    if (dirty) repl_page_->refresh();
+    if (repl_page_->poll()) dirty = true;
+
+    if (g_resize || dirty) {
       if (g_resize) {
         g_resize = false;
         handle_resize();
@@ -192,6 +201,8 @@ void App::init_curses() {
   noecho();
   keypad(stdscr, TRUE);
   nodelay(stdscr, FALSE);
+  // Bounded getch() so event-driven re-renders don't wait for a keypress.
+  timeout((int)k_poll_interval_.count());
 
   // Try to enable colors (best-effort).
   tui::styles::init_colors();
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <memory>
 #include <vector>
 
@@ -18,13 +20,15 @@ namespace tui {
 
 class App {
  public:
+  // The providers and send function must go through the services' async_*
+  // calls (see ReplPage); the UI thread never runs SQLite itself.
   App(logging::Logger& logger,
       ReplPage::SessionsProvider sessions_provider,
       ReplPage::MessagesProvider messages_provider,
       ReplPage::SendFn send,
-      std::shared_ptr<pubsub::Channel<pubsub::Event<message::Message>>> message_subscriber,
-      std::shared_ptr<pubsub::Channel<pubsub::Event<session::Session>>> session_subscriber,
-      std::shared_ptr<pubsub::Channel<pubsub::Event<permission::PermissionRequest>>> permission_subscriber);
+      pubsub::EventSubscription<message::Message> message_subscriber,
+      pubsub::EventSubscription<session::Session> session_subscriber,
+      pubsub::EventSubscription<permission::PermissionRequest> permission_subscriber);
 
   // Runs the blocking UI loop. Returns when the user quits.
   int run();
@@ -40,9 +44,9 @@ class App {
   void toggle_help();
 
   logging::Logger& logger_;
-  std::shared_ptr<pubsub::Channel<pubsub::Event<message::Message>>> message_subscriber_;
-  std::shared_ptr<pubsub::Channel<pubsub::Event<session::Session>>> session_subscriber_;
-  std::shared_ptr<pubsub::Channel<pubsub::Event<permission::PermissionRequest>>> permission_subscriber_;
+  pubsub::EventSubscription<message::Message> message_subscriber_;
+  pubsub::EventSubscription<session::Session> session_subscriber_;
+  pubsub::EventSubscription<permission::PermissionRequest> permission_subscriber_;
   RenderCtx ctx_{};
 
   PageId current_ = PageId::Repl;
@@ -58,7 +62,10 @@ class App {
   static constexpr int k_status_height_ = 1;
   static constexpr int k_help_height_ = 6;
 
-  bool running_ = true;
+  static constexpr std::chrono::milliseconds k_poll_interval_{50};
+  static constexpr std::size_t k_max_batch_ = 512;
+
+  std::atomic<bool> running_{true};
   std::atomic<bool> needs_render_{false};
 };
 
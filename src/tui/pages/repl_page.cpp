@@ -1,19 +1,78 @@
 #include "tui/pages/repl_page.hpp"
 
+#include <chrono>
+#include <exception>
+
 #include <curses.h>
 
 namespace tui {
 
-ReplPage::ReplPage(SessionsProvider sessions_provider, MessagesProvider messages_provider, SendFn send)
-    : sessions_provider_(std::move(sessions_provider)),
+ReplPage::ReplPage(logging::Logger& logger, SessionsProvider sessions_provider,
+                   MessagesProvider messages_provider, SendFn send)
+    : logger_(logger),
+      sessions_provider_(std::move(sessions_provider)),
       messages_provider_(std::move(messages_provider)),
       send_(std::move(send)) {}
 
+void ReplPage::refresh() {
+  stale_ = true;
+}
+
+template <typename T>
+static bool ready(const std::future<T>& f) {
+  return f.valid() && f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+// Takes a finished fetch into `into`; on failure keeps the previous contents.
+static void collect(logging::Logger& logger, std::future<std::vector<std::string>>& f,
+                    std::vector<std::string>& into, const char* what) {
+  try {
+    into = f.get();
+  } catch (const std::exception& e) {
+    logger.error(std::string("Loading ") + what + " failed: " + e.what());
+  }
+}
+
+bool ReplPage::poll() {
+  bool changed = false;
+  if (ready(sessions_pending_)) {
+    collect(logger_, sessions_pending_, sessions_, "sessions");
+    sessions_loaded_ = changed = true;
+  }
+  if (ready(messages_pending_)) {
+    collect(logger_, messages_pending_, messages_, "messages");
+    messages_loaded_ = changed = true;
+  }
+
+  for (auto it = sends_.begin(); it != sends_.end();) {
+    if (!ready(*it)) {
+      ++it;
+      continue;
+    }
+    try {
+      it->get();
+    } catch (const std::exception& e) {
+      logger_.error(std::string("Sending message failed: ") + e.what());
+      changed = true;
+    }
+    it = sends_.erase(it);
+  }
+
+  // One fetch of each list in flight at a time; events that arrive meanwhile
+  // fold into the next one.
+  if (stale_ && !sessions_pending_.valid() && !messages_pending_.valid()) {
+    stale_ = false;
+    if (sessions_provider_) sessions_pending_ = sessions_provider_();
+    if (messages_provider_) messages_pending_ = messages_provider_();
+  }
+  return changed;
+}
+
 void ReplPage::on_key(int ch) {
   // Enter sends message.
   if (ch == '\n' || ch == '\r' || ch == KEY_ENTER) {
     if (!input_.empty() && send_) {
-      send_(input_);
+      sends_.push_back(send_(input_));
       input_.clear();
     }
     return;
@@ -41,8 +100,10 @@ void ReplPage::render(RenderCtx ctx) {
   row++;
   mvprintw(row++, 0, "Sessions:");
   if (sessions_provider_) {
-    auto titles = sessions_provider_();
-    if (titles.empty()) {
+    const auto& titles = sessions_;
+    if (!sessions_loaded_) {
+      mvprintw(row++, 0, "  (loading)");
+    } else if (titles.empty()) {
       mvprintw(row++, 0, "  (none)");
     } else {
       for (int i = 0; i < (int)titles.size() && row < ctx.height - 6; i++) {
@@ -55,8 +116,10 @@ void ReplPage::render(RenderCtx ctx) {
   row++;
   mvprintw(row++, 0, "Messages:");
   if (messages_provider_) {
-    auto msgs = messages_provider_();
-    if (msgs.empty()) {
+    const auto& msgs = messages_;
+    if (!messages_loaded_) {
+      mvprintw(row++, 0, "  (loading)");
+    } else if (msgs.empty()) {
       mvprintw(row++, 0, "  (no messages)");
     } else {
       int max_rows = ctx.height - row - 4;
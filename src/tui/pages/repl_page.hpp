@@ -1,31 +1,54 @@
 #pragma once
 
 #include <functional>
+#include <future>
 #include <string>
 #include <vector>
 
+#include "logging/logger.hpp"
 #include "tui/page.hpp"
 
 namespace tui {
 
 class ReplPage final : public Page {
  public:
-  using SessionsProvider = std::function<std::vector<std::string>()>;
-  using MessagesProvider = std::function<std::vector<std::string>()>;
-  using SendFn = std::function<void(std::string)>;
+  // Each call starts the work on the services' async_* path (db::Executor)
+  // and returns its future, so neither rendering nor key handling waits on
+  // SQLite.
+  using SessionsProvider = std::function<std::future<std::vector<std::string>>()>;
+  using MessagesProvider = std::function<std::future<std::vector<std::string>>()>;
+  using SendFn = std::function<std::future<void>(std::string)>;
 
-  ReplPage(SessionsProvider sessions_provider, MessagesProvider messages_provider, SendFn send);
+  ReplPage(logging::Logger& logger, SessionsProvider sessions_provider,
+           MessagesProvider messages_provider, SendFn send);
 
   PageId id() const override { return PageId::Repl; }
   void on_resize(RenderCtx) override {}
   void on_key(int ch) override;
   void render(RenderCtx ctx) override;
 
+  // Marks the lists stale; the next poll() refetches them.
+  void refresh();
+  // Collects finished fetches and sends (logging failures) and starts a due
+  // refetch. Never blocks. Returns true if there is something new to render.
+  bool poll();
+
  private:
+  logging::Logger& logger_;
   SessionsProvider sessions_provider_;
   MessagesProvider messages_provider_;
   SendFn send_;
 
+  // What render() draws: the last completed fetch of each list.
+  std::vector<std::string> sessions_;
+  std::vector<std::string> messages_;
+  bool sessions_loaded_ = false;
+  bool messages_loaded_ = false;
+  bool stale_ = true;
+  std::future<std::vector<std::string>> sessions_pending_;
+  std::future<std::vector<std::string>> messages_pending_;
+  std::vector<std::future<void>> sends_;
+
   std::string input_;
 };
 
@@ -0,0 +1,83 @@
+// Ids must keep increasing when more than 65536 are taken in one millisecond
+// (the 16-bit sequence overflows into the next millisecond) and when the
+// clock stands still or goes back.
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "db/id.hpp"
+
+static bool increasing(const char* name, const std::vector<std::string>& ids) {
+  for (std::size_t i = 1; i < ids.size(); i++) {
+    if (ids[i] <= ids[i - 1]) {
+      std::fprintf(stderr, "%s: id %zu (%s) not after %s\n", name, i, ids[i].c_str(),
+                   ids[i - 1].c_str());
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool sequence_overflow() {
+  db::IdGenerator gen;
+  std::vector<std::string> ids;
+  // Three sequences' worth at a frozen clock, then the clock catching up to a
+  // millisecond the generator already borrowed, then jumping back.
+  for (int i = 0; i < 3 * 65536; i++) ids.push_back(gen.next(1000));
+  for (int i = 0; i < 10; i++) ids.push_back(gen.next(1001));
+  for (int i = 0; i < 10; i++) ids.push_back(gen.next(500));
+  ids.push_back(gen.next(5000));
+  if (!increasing("sequence_overflow", ids)) return false;
+
+  struct Want {
+    std::size_t index;
+    std::int64_t ms;
+    const char* seq;
+  };
+  for (Want w : {Want{0, 1000, "0000"}, Want{65535, 1000, "ffff"}, Want{65536, 1001, "0000"},
+                 Want{3 * 65536 - 1, 1002, "ffff"}, Want{3 * 65536, 1003, "0000"},
+                 Want{ids.size() - 1, 5000, "0000"}}) {
+    const auto& id = ids[w.index];
+    if (id.size() != 32 || db::id_time_ms(id) != w.ms || id.substr(12, 4) != w.seq) {
+      std::fprintf(stderr, "sequence_overflow: id %zu is %s, want ms %lld seq %s\n", w.index,
+                   id.c_str(), (long long)w.ms, w.seq);
+      return false;
+    }
+  }
+  return true;
+}
+
+// new_id() from several threads: every thread's ids increase, and none repeat.
+static bool concurrent() {
+  constexpr int k_threads = 4;
+  constexpr int k_per_thread = 50000;
+  std::vector<std::vector<std::string>> per(k_threads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < k_threads; t++) {
+    threads.emplace_back([&per, t] {
+      for (int i = 0; i < k_per_thread; i++) per[(std::size_t)t].push_back(db::new_id());
+    });
+  }
+  for (auto& t : threads) t.join();
+
+  std::vector<std::string> all;
+  for (const auto& ids : per) {
+    if (!increasing("concurrent", ids)) return false;
+    all.insert(all.end(), ids.begin(), ids.end());
+  }
+  std::sort(all.begin(), all.end());
+  if (std::adjacent_find(all.begin(), all.end()) != all.end()) {
+    std::fprintf(stderr, "concurrent: duplicate id\n");
+    return false;
+  }
+  return true;
+}
+
+int main() {
+  bool ok = sequence_overflow();
+  ok = concurrent() && ok;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,148 @@
+// Cancelling a turn must stop it promptly wherever it is blocked: on the API
+// itself when llm::Service is destroyed, or waiting for an in-flight permit.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <thread>
+
+#include "config.hpp"
+#include "db/pool.hpp"
+#include "llm/llm.hpp"
+#include "logging/logger.hpp"
+#include "message/message.hpp"
+
+// Accepts one connection, reads the request and never answers.
+class SilentServer {
+ public:
+  SilentServer() {
+    fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(fd_, (sockaddr*)&addr, sizeof(addr));
+    socklen_t len = sizeof(addr);
+    getsockname(fd_, (sockaddr*)&addr, &len);
+    port_ = ntohs(addr.sin_port);
+    listen(fd_, 1);
+    thread_ = std::thread([this] {
+      int conn = accept(fd_, nullptr, nullptr);
+      if (conn < 0) return;
+      char buf[4096];
+      if (read(conn, buf, sizeof(buf)) > 0) received_ = true;
+      // Held open until the client gives up.
+      while (read(conn, buf, sizeof(buf)) > 0) {
+      }
+      close(conn);
+    });
+  }
+  ~SilentServer() {
+    shutdown(fd_, SHUT_RDWR);
+    close(fd_);
+    thread_.join();
+  }
+
+  int port() const { return port_; }
+  bool received() const { return received_; }
+
+ private:
+  int fd_ = -1;
+  int port_ = 0;
+  std::atomic<bool> received_{false};
+  std::thread thread_;
+};
+
+// Polls until pred() holds or `timeout` passes; returns pred().
+template <typename Pred>
+static bool wait_for(Pred pred, std::chrono::milliseconds timeout) {
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (!pred() && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return pred();
+}
+
+struct Fixture {
+  explicit Fixture(const char* name) : dir(std::filesystem::temp_directory_path() / name) {
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    cfg.data_dir = dir.string();
+    cfg.llm_api_key = "test";
+    cfg.llm_base_url = "http://127.0.0.1:" + std::to_string(server.port()) + "/v1";
+  }
+  ~Fixture() { std::filesystem::remove_all(dir); }
+
+  std::filesystem::path dir;
+  SilentServer server;
+  config::Config cfg;
+  logging::Logger log;
+};
+
+// ~Service with a turn waiting on a server that never answers.
+static bool destroy_mid_turn() {
+  using namespace std::chrono_literals;
+  Fixture f("openvim_llm_shutdown_test");
+  db::Pool pool(f.cfg.data_dir, 1);
+  message::Service messages(pool);
+
+  auto start = std::chrono::steady_clock::now();
+  {
+    llm::Service llm(f.log, messages, f.cfg);
+    llm.send_request("session", "hello");
+    if (!wait_for([&] { return f.server.received(); }, 5s)) {
+      std::fprintf(stderr, "request never reached the server\n");
+      return false;
+    }
+    start = std::chrono::steady_clock::now();
+  }
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+  if (elapsed > 1s) {
+    std::fprintf(stderr, "~Service took %lld ms with a turn in flight\n",
+                 (long long)elapsed.count());
+    return false;
+  }
+  return true;
+}
+
+// With max_in_flight = 1 and one call stuck on the server, a second
+// session's turn waits for a permit; cancelling it must end that wait.
+static bool cancel_waiting_for_permit() {
+  using namespace std::chrono_literals;
+  Fixture f("openvim_llm_cancel_wait_test");
+  f.cfg.llm_workers = 2;
+  f.cfg.llm_max_in_flight = 1;
+  db::Pool pool(f.cfg.data_dir, 1);
+  message::Service messages(pool);
+  llm::Service llm(f.log, messages, f.cfg);
+
+  llm.send_request("first", "hello");
+  if (!wait_for([&] { return f.server.received(); }, 5s)) {
+    std::fprintf(stderr, "request never reached the server\n");
+    return false;
+  }
+  llm.send_request("second", "hello");
+  if (!wait_for([&] { return llm.metrics().scheduler.waiting_calls == 1; }, 5s)) {
+    std::fprintf(stderr, "second turn never waited for a permit\n");
+    return false;
+  }
+
+  llm.cancel("second");
+  if (!wait_for([&] { return llm.metrics().cancelled == 1; }, 1s)) {
+    std::fprintf(stderr, "cancelled turn still waiting for a permit after 1 s\n");
+    return false;
+  }
+  return true;
+}
+
+int main() {
+  bool ok = destroy_mid_turn();
+  ok = cancel_waiting_for_permit() && ok;
+  return ok ? 0 : 1;
+}
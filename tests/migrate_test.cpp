@@ -0,0 +1,169 @@
+// db::apply_migrations must bring up databases written before user_version
+// was used, adopting whatever schema_migrations says already ran and
+// migrating the rows those builds left behind.
+
+#include <cstdio>
+#include <iterator>
+#include <set>
+#include <stdexcept>
+#include <string>
+
+#include <sqlite3.h>
+
+#include "db/embedded_migrations.hpp"
+#include "db/id.hpp"
+#include "db/migrate.hpp"
+
+static const auto& k_all = db::embedded::k_migrations;
+static const int k_latest = k_all[std::size(k_all) - 1].number;
+
+class Conn {
+ public:
+  Conn() {
+    if (sqlite3_open(":memory:", &db_) != SQLITE_OK) throw std::runtime_error("open failed");
+  }
+  ~Conn() { sqlite3_close(db_); }
+  Conn(const Conn&) = delete;
+  Conn& operator=(const Conn&) = delete;
+
+  sqlite3* get() const { return db_; }
+
+  void exec(const std::string& sql) {
+    char* err = nullptr;
+    if (sqlite3_exec(db_, sql.c_str(), nullptr, nullptr, &err) != SQLITE_OK) {
+      std::string msg = err ? err : "sqlite error";
+      sqlite3_free(err);
+      throw std::runtime_error(msg + " in: " + sql);
+    }
+  }
+
+  // First column of the first row as text, or "" if there is none.
+  std::string query(const std::string& sql) {
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+      throw std::runtime_error(std::string(sqlite3_errmsg(db_)) + " in: " + sql);
+    }
+    std::string out;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+      auto text = (const char*)sqlite3_column_text(stmt, 0);
+      if (text) out = text;
+    }
+    sqlite3_finalize(stmt);
+    return out;
+  }
+
+ private:
+  sqlite3* db_ = nullptr;
+};
+
+static bool expect(const char* name, const std::string& got, const std::string& want) {
+  if (got == want) return true;
+  std::fprintf(stderr, "%s: got \"%s\", want \"%s\"\n", name, got.c_str(), want.c_str());
+  return false;
+}
+
+// Every embedded version is recorded and user_version is the latest.
+static bool fully_applied(const char* name, Conn& c) {
+  bool ok = expect(name, c.query("PRAGMA user_version;"), std::to_string(k_latest));
+  ok = expect(name, c.query("SELECT count(*) FROM schema_migrations;"),
+              std::to_string(std::size(k_all))) && ok;
+  for (const auto& m : k_all) {
+    auto sql = "SELECT count(*) FROM schema_migrations WHERE version = '" + std::string(m.version) + "';";
+    ok = expect(name, c.query(sql), "1") && ok;
+  }
+  return ok;
+}
+
+// A database from the build that only had 0001 and schema_migrations, with
+// random ids: the remaining migrations run and rewrite its rows.
+static bool legacy_initial() {
+  Conn c;
+  c.exec(std::string(k_all[0].up_sql));
+  c.exec("INSERT INTO schema_migrations(version, applied_at) VALUES('" +
+         std::string(k_all[0].version) + "', 0);");
+  c.exec(
+      "INSERT INTO sessions(id, title, created_at) VALUES"
+      "  ('9f3c0a5e7d1b42c8a6e4f0b2d8c6a4e2', 'old', 1700000000);"
+      "INSERT INTO messages(id, session_id, role, content, created_at) VALUES"
+      "  ('c4d2e0f8a6b4c2d0e8f6a4b2c0d8e6f4', '9f3c0a5e7d1b42c8a6e4f0b2d8c6a4e2', 'user',"
+      "   'needle in an old message', 1700000001),"
+      "  ('18a6c4e2f0d8b6a4c2e0f8d6b4a2c0e8', '9f3c0a5e7d1b42c8a6e4f0b2d8c6a4e2', 'assistant',"
+      "   'the reply', 1700000001);");
+
+  db::apply_migrations(c.get());
+
+  bool ok = fully_applied("legacy_initial", c);
+  // 0004: same-second rows keep their insertion order in the new ids.
+  auto first = c.query("SELECT id FROM messages WHERE role = 'user';");
+  auto second = c.query("SELECT id FROM messages WHERE role = 'assistant';");
+  ok = expect("legacy_initial id ms", std::to_string(db::id_time_ms(first)), "1700000001000") && ok;
+  ok = expect("legacy_initial id order", first < second ? "ordered" : first + " >= " + second,
+              "ordered") && ok;
+  ok = expect("legacy_initial session id",
+              c.query("SELECT count(*) FROM messages m JOIN sessions s ON s.id = m.session_id;"),
+              "2") && ok;
+  // 0002: rows that existed before the index are searchable.
+  ok = expect("legacy_initial fts",
+              c.query("SELECT m.role FROM messages_fts JOIN messages m ON m.seq = messages_fts.rowid "
+                      "WHERE messages_fts MATCH 'needle';"),
+              "user") && ok;
+  // 0005: summaries are backfilled.
+  ok = expect("legacy_initial summary", c.query("SELECT message_count || ':' || preview FROM sessions;"),
+              "2:the reply") && ok;
+  return ok;
+}
+
+// A database whose schema_migrations lists every version but whose
+// user_version was never set: nothing may run again (0003's ALTER TABLE
+// would fail), only user_version is adopted.
+static bool legacy_complete() {
+  Conn c;
+  db::apply_migrations(c.get());
+  c.exec("PRAGMA user_version = 0;");
+  try {
+    db::apply_migrations(c.get());
+  } catch (const std::exception& e) {
+    std::fprintf(stderr, "legacy_complete: %s\n", e.what());
+    return false;
+  }
+  return fully_applied("legacy_complete", c);
+}
+
+// schema_migrations exists but is empty: everything runs, and the IF NOT
+// EXISTS in 0001 tolerates the table.
+static bool legacy_empty_table() {
+  Conn c;
+  c.exec("CREATE TABLE schema_migrations (version TEXT PRIMARY KEY, applied_at INTEGER NOT NULL);");
+  db::apply_migrations(c.get());
+  return fully_applied("legacy_empty_table", c);
+}
+
+// Up to date: a second call changes nothing; a newer schema is refused.
+static bool current_and_newer() {
+  Conn c;
+  db::apply_migrations(c.get());
+  db::apply_migrations(c.get());
+  bool ok = fully_applied("current", c);
+
+  c.exec("PRAGMA user_version = " + std::to_string(k_latest + 1) + ";");
+  try {
+    db::apply_migrations(c.get());
+    std::fprintf(stderr, "newer: schema from a newer build was accepted\n");
+    ok = false;
+  } catch (const std::runtime_error&) {
+  }
+  return ok;
+}
+
+int main() {
+  bool ok = true;
+  for (auto test : {legacy_initial, legacy_complete, legacy_empty_table, current_and_newer}) {
+    try {
+      ok = test() && ok;
+    } catch (const std::exception& e) {
+      std::fprintf(stderr, "%s\n", e.what());
+      ok = false;
+    }
+  }
+  return ok ? 0 : 1;
+}
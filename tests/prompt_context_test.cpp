@@ -0,0 +1,120 @@
+// llm::PromptContext must serialize a session in id order whatever order its
+// messages arrive in, ignore replays, and match user messages exactly.
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "llm/context.hpp"
+
+static message::Message msg(const std::string& id, message::Role role) {
+  message::Message m;
+  m.id = id;
+  m.session_id = "session";
+  m.role = role;
+  return m;
+}
+
+struct Item {
+  std::string id;
+  message::Role role;
+  std::string content;
+};
+
+static std::string joined(const std::vector<Item>& items) {
+  std::string out;
+  for (const auto& it : items) {
+    if (!out.empty()) out += ',';
+    out += llm::message_json(it.role, it.content);
+  }
+  return out;
+}
+
+static const std::vector<Item> k_history = {
+    {"01", message::Role::User, "first"},
+    {"02", message::Role::Assistant, "reply with \"quotes\"\nand a newline"},
+    {"03", message::Role::User, "second"},
+    {"04", message::Role::Assistant, "done"},
+    {"05", message::Role::User, "third \xc3\xa9"},
+};
+
+static bool check(const char* name, const llm::PromptContext& ctx, const std::vector<Item>& want) {
+  if (ctx.serialized() == joined(want) && ctx.size() == want.size()) return true;
+  std::fprintf(stderr, "%s: got [%s]\n  want [%s]\n", name, ctx.serialized().c_str(),
+               joined(want).c_str());
+  return false;
+}
+
+// Any arrival order yields the id-ordered serialization, and lookups still
+// find each user message at its (shifted) offset afterwards.
+static bool ordering() {
+  const std::vector<std::vector<int>> orders = {
+      {0, 1, 2, 3, 4}, {4, 3, 2, 1, 0}, {2, 0, 4, 1, 3}, {1, 3, 0, 4, 2}};
+  for (const auto& order : orders) {
+    llm::PromptContext ctx;
+    for (int i : order) {
+      const auto& it = k_history[(std::size_t)i];
+      ctx.append(msg(it.id, it.role), it.content);
+    }
+    std::string name = "order";
+    for (int i : order) name += " " + std::to_string(i);
+    if (!check(name.c_str(), ctx, k_history)) return false;
+    for (const auto& it : k_history) {
+      bool want = it.role == message::Role::User;
+      if (ctx.has_user_message(it.content) != want) {
+        std::fprintf(stderr, "%s: has_user_message(\"%s\") != %d\n", name.c_str(),
+                     it.content.c_str(), (int)want);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Replaying an event the context already holds (e.g. one that raced the
+// initial load) changes nothing.
+static bool dedup() {
+  llm::PromptContext ctx;
+  for (const auto& it : k_history) ctx.append(msg(it.id, it.role), it.content);
+  auto bytes = ctx.bytes();
+  ctx.append(msg("03", message::Role::User), "second");
+  ctx.append(msg("01", message::Role::User), "a different text for the same id");
+  ctx.append(msg("05", message::Role::User), "third \xc3\xa9");
+  if (ctx.bytes() != bytes) {
+    std::fprintf(stderr, "dedup: %zu bytes after replays, want %zu\n", ctx.bytes(), bytes);
+    return false;
+  }
+  bool ok = check("dedup", ctx, k_history);
+  if (ctx.has_user_message("a different text for the same id")) {
+    std::fprintf(stderr, "dedup: replayed text was indexed\n");
+    ok = false;
+  }
+  return ok;
+}
+
+// Only an exact user message matches: not an assistant one with the same
+// text, a prefix, or a longer string.
+static bool exact_match() {
+  llm::PromptContext ctx;
+  ctx.append(msg("01", message::Role::User), "hello world");
+  ctx.append(msg("02", message::Role::Assistant), "echo");
+  bool ok = true;
+  for (const char* text : {"hello", "hello world!", "echo", ""}) {
+    if (ctx.has_user_message(text)) {
+      std::fprintf(stderr, "exact_match: \"%s\" matched\n", text);
+      ok = false;
+    }
+  }
+  if (!ctx.has_user_message("hello world")) {
+    std::fprintf(stderr, "exact_match: \"hello world\" not found\n");
+    ok = false;
+  }
+  return ok;
+}
+
+int main() {
+  bool ok = ordering();
+  ok = dedup() && ok;
+  ok = exact_match() && ok;
+  return ok ? 0 : 1;
+}
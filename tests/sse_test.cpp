@@ -0,0 +1,76 @@
+// llm::SseParser must produce the same events however the stream is split
+// into chunks, join multi-line data, and hand "[DONE]" through as data.
+
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "llm/sse.hpp"
+
+using Events = std::vector<std::pair<std::string, std::string>>;
+
+static Events parse(const std::vector<std::string>& chunks) {
+  Events out;
+  llm::SseParser sse([&](const std::string& event, const std::string& data) {
+    out.emplace_back(event, data);
+  });
+  for (const auto& c : chunks) sse.feed(c);
+  sse.finish();
+  return out;
+}
+
+static bool expect(const char* name, const Events& got, const Events& want) {
+  if (got == want) return true;
+  std::fprintf(stderr, "%s: got %zu events, want %zu\n", name, got.size(), want.size());
+  for (const auto& [event, data] : got) {
+    std::fprintf(stderr, "  %s: %s\n", event.c_str(), data.c_str());
+  }
+  return false;
+}
+
+static const char* k_stream =
+    ": keep-alive\r\n"
+    "data: {\"a\":1}\r\n"
+    "\r\n"
+    "event: usage\n"
+    "data: first line\n"
+    "data: second line\n"
+    "data:third\n"
+    "\n"
+    "data: [DONE]\n"
+    "\n";
+
+static const Events k_events = {
+    {"message", "{\"a\":1}"},
+    {"usage", "first line\nsecond line\nthird"},
+    {"message", "[DONE]"},
+};
+
+// Every two-chunk split, including ones between '\r' and '\n'.
+static bool split_frames() {
+  std::string stream = k_stream;
+  for (std::size_t cut = 0; cut <= stream.size(); cut++) {
+    auto got = parse({stream.substr(0, cut), stream.substr(cut)});
+    if (!expect(("split at " + std::to_string(cut)).c_str(), got, k_events)) return false;
+  }
+
+  std::vector<std::string> bytes;
+  for (char c : stream) bytes.emplace_back(1, c);
+  return expect("byte at a time", parse(bytes), k_events);
+}
+
+// An event the server didn't terminate with a blank line still arrives on
+// finish(); one with no data lines never does.
+static bool unterminated() {
+  bool ok = expect("trailing event", parse({"data: [DONE]"}), {{"message", "[DONE]"}});
+  ok = expect("no data", parse({"event: ping\n\n: comment\n"}), {}) && ok;
+  ok = expect("empty data line", parse({"data:\n\n"}), {{"message", ""}}) && ok;
+  return ok;
+}
+
+int main() {
+  bool ok = split_frames();
+  ok = unterminated() && ok;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,181 @@
+// transfer::export_jsonl and import_jsonl must round-trip hot and archived
+// sessions (blob-sized content included) and reject bad input by line,
+// keeping the batches committed before it.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "db/pool.hpp"
+#include "message/message.hpp"
+#include "session/session.hpp"
+#include "transfer/transfer.hpp"
+
+struct TempDir {
+  explicit TempDir(const char* name) : path(std::filesystem::temp_directory_path() / name) {
+    std::filesystem::remove_all(path);
+    std::filesystem::create_directories(path);
+  }
+  ~TempDir() { std::filesystem::remove_all(path); }
+  std::string str() const { return path.string(); }
+  std::filesystem::path path;
+};
+
+static std::vector<std::string> sorted_lines(const std::string& text) {
+  std::vector<std::string> out;
+  std::istringstream in(text);
+  std::string line;
+  while (std::getline(in, line)) out.push_back(line);
+  std::sort(out.begin(), out.end());
+  return out;
+}
+
+static bool fail(const char* name, const std::string& what) {
+  std::fprintf(stderr, "%s: %s\n", name, what.c_str());
+  return false;
+}
+
+// Export a database with an archived session and a blob-sized message,
+// import it elsewhere in small batches, export again: the same lines.
+static bool round_trip() {
+  TempDir src_dir("openvim_transfer_test_src");
+  TempDir dst_dir("openvim_transfer_test_dst");
+  const std::string big(40000, 'b');
+
+  std::string exported;
+  {
+    db::Pool pool(src_dir.str(), 1);
+    session::Service sessions(pool);
+    message::Service messages(pool);
+    auto old = sessions.create("archived");
+    messages.create_user(old.id, "archived needle");
+    auto moved = sessions.archive_idle(std::chrono::hours(-1));
+    if (moved.size() != 1) return fail("round_trip", "archive_idle moved " + std::to_string(moved.size()));
+
+    auto hot = sessions.create("hot \"quoted\"");
+    messages.create_user(hot.id, "hot needle\nsecond line");
+    messages.create_assistant(hot.id, big);
+
+    std::ostringstream out;
+    auto stats = transfer::export_jsonl(pool, out);
+    if (stats.sessions != 2 || stats.messages != 3) {
+      return fail("round_trip", "exported " + std::to_string(stats.sessions) + " sessions, " +
+                                    std::to_string(stats.messages) + " messages");
+    }
+    exported = out.str();
+  }
+
+  db::Pool pool(dst_dir.str(), 1);
+  transfer::ImportOptions opts;
+  opts.batch = 2;
+  opts.batch_bytes = 1024;
+  std::istringstream in(exported);
+  auto stats = transfer::import_jsonl(pool, in, opts);
+  if (stats.sessions != 2 || stats.messages != 3) {
+    return fail("round_trip", "imported " + std::to_string(stats.sessions) + " sessions, " +
+                                  std::to_string(stats.messages) + " messages");
+  }
+
+  std::ostringstream again;
+  transfer::export_jsonl(pool, again);
+  if (sorted_lines(again.str()) != sorted_lines(exported)) {
+    return fail("round_trip", "re-export differs:\n" + again.str() + "\nwant:\n" + exported);
+  }
+
+  // Imported rows are indexed, stored as blobs past the threshold, and
+  // importing the same file again adds nothing.
+  message::Service messages(pool);
+  if (messages.search("needle", 10).size() != 2) return fail("round_trip", "search missed imported rows");
+  bool found_big = false;
+  for (const auto& s : session::Service(pool).list()) {
+    for (const auto& m : messages.list(s.id)) {
+      if (m.partial && messages.full_content(m) == big) found_big = true;
+    }
+  }
+  if (!found_big) return fail("round_trip", "blob-sized message not stored as a blob");
+
+  std::istringstream in2(exported);
+  auto repeat = transfer::import_jsonl(pool, in2, opts);
+  if (repeat.sessions != 0 || repeat.messages != 0) return fail("round_trip", "re-import added rows");
+  return true;
+}
+
+// Returns the error import_jsonl threw, or "" if it succeeded.
+static std::string import_error(db::Pool& pool, const std::string& text,
+                                transfer::ImportOptions opts = {}) {
+  std::istringstream in(text);
+  try {
+    transfer::import_jsonl(pool, in, opts);
+  } catch (const std::exception& e) {
+    return e.what();
+  }
+  return "";
+}
+
+static std::string session_line(const std::string& id) {
+  return R"({"type":"session","id":")" + id + R"(","title":"t","created_at":1})" "\n";
+}
+
+static std::string message_line(const std::string& id, const std::string& session,
+                                const std::string& role = "user") {
+  return R"({"type":"message","id":")" + id + R"(","session_id":")" + session +
+         R"(","role":")" + role + R"(","content":"c","created_at":1})" "\n";
+}
+
+static bool expect_error(const char* name, const std::string& got, const std::string& prefix) {
+  if (got.rfind(prefix, 0) == 0) return true;
+  return fail(name, "error \"" + got + "\", want it to start with \"" + prefix + "\"");
+}
+
+static bool rejected_lines() {
+  TempDir dir("openvim_transfer_test_rejected");
+  db::Pool pool(dir.str(), 1);
+  message::Service messages(pool);
+  bool ok = true;
+
+  // A message whose session doesn't exist fails the foreign key when its
+  // batch is flushed; the error still names its own line, and the batch
+  // committed before it (lines 1-2) stays.
+  transfer::ImportOptions opts;
+  opts.batch = 2;
+  auto err = import_error(pool,
+                          session_line("s1") + message_line("m1", "s1") + "\n" +
+                              message_line("m2", "s1") + message_line("m3", "missing"),
+                          opts);
+  ok = expect_error("unknown session", err, "import line 5:") && ok;
+  auto kept = messages.list("s1");
+  if (kept.size() != 1 || kept[0].id != "m1") {
+    ok = fail("unknown session", std::to_string(kept.size()) + " messages kept, want only m1");
+  }
+
+  ok = expect_error("malformed", import_error(pool, session_line("s2") + "{not json\n"),
+                    "import line 2:") && ok;
+  ok = expect_error("unknown type",
+                    import_error(pool, R"({"type":"blob","id":"x"})" "\n"), "import line 1:") && ok;
+  ok = expect_error("unknown role",
+                    import_error(pool, session_line("s3") + message_line("m4", "s3", "system")),
+                    "import line 2:") && ok;
+
+  // A failed import leaves nothing staged behind for the next one.
+  auto clean = import_error(pool, session_line("s4") + message_line("m5", "s4"));
+  if (!clean.empty()) ok = fail("after failure", clean);
+  if (messages.list("s4").size() != 1) ok = fail("after failure", "m5 not imported");
+  return ok;
+}
+
+int main() {
+  bool ok = true;
+  for (auto test : {round_trip, rejected_lines}) {
+    try {
+      ok = test() && ok;
+    } catch (const std::exception& e) {
+      std::fprintf(stderr, "%s\n", e.what());
+      ok = false;
+    }
+  }
+  return ok ? 0 : 1;
+}